@@ -0,0 +1,476 @@
+// Общий набор микробенчмарков: компоненты репозитория против аналогов из
+// стандартной библиотеки, результат - JSON для сравнения запусков.
+//
+//   g++ -std=c++20 -O2 -pthread bench/microbench.cpp -o microbench
+//   ./microbench [--out results.json] [--filter подстрока]
+//
+// Каждый файл компонента - отдельная программа со своим main и своими
+// вспомогательными классами (ThreadPool, CountingBuf, runBenchmark...).
+// Поэтому файлы подключаются целиком, каждый в собственное пространство
+// имён: их main становится обычной функцией, а одноимённые классы не
+// конфликтуют. Все системные заголовки подключаются заранее, вне этих
+// пространств имён, - повторные #include внутри них пусты
+
+#include <algorithm>
+#include <any>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <random>
+#include <shared_mutex>
+#include <source_location>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include "../hw/Instrumentation.h"
+
+namespace shared_ptr_component {
+#include "../sem_2/MyShared.cpp"
+}
+namespace log_component {
+#include "../hw/Log.cpp"
+}
+namespace type_map_component {
+#include "../hw/TypeMap.cpp"
+}
+namespace users_component {
+#include "../hw/UsersAndGroup.cpp"
+}
+namespace builder_component {
+#include "../hw/Builder.cpp"
+}
+namespace const_array_component {
+#include "../sem_4/sem4.cpp"
+}
+
+namespace {
+
+// Результат одного замера: операция компонента и её стандартный аналог
+struct Result {
+    std::string component;
+    std::string operation;
+    double nsPerOp;
+    std::string baseline;
+    double baselineNsPerOp;
+};
+
+// Время одной операции: медиана из REPEATS прогонов по iterations операций.
+// prepare вызывается перед каждым прогоном вне замера
+constexpr int REPEATS = 5;
+
+template <typename Prepare, typename Run>
+double measure(size_t iterations, Prepare&& prepare, Run&& run) {
+    std::array<double, REPEATS> samples;
+    for (double& sample : samples) {
+        prepare();
+        auto begin = std::chrono::steady_clock::now();
+        run(iterations);
+        sample = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() /
+                 static_cast<double>(iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[REPEATS / 2];
+}
+
+template <typename Run>
+double measure(size_t iterations, Run&& run) {
+    return measure(iterations, [] {}, std::forward<Run>(run));
+}
+
+// Не даёт компилятору выбросить вычисленное значение
+template <typename T>
+void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Поток, выбрасывающий всё записанное
+class NullBuf : public std::streambuf {
+protected:
+    int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+std::vector<std::string> makeIds(const char* prefix, size_t count) {
+    std::vector<std::string> ids;
+    ids.reserve(count);
+    for (size_t i = 0; i < count; ++i) ids.push_back(prefix + std::to_string(i));
+    return ids;
+}
+
+void benchMyShared(std::vector<Result>& results) {
+    using shared_ptr_component::MyShared;
+    MyShared<int>::trace = false;
+    const size_t n = 10000000;
+    MyShared<int> mine(new int(42));
+    auto standard = std::make_shared<int>(42);
+    double ours = measure(n, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            MyShared<int> copy(mine);
+            keep(*copy);
+        }
+    });
+    double theirs = measure(n, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            std::shared_ptr<int> copy(standard);
+            keep(*copy);
+        }
+    });
+    results.push_back({"MyShared", "copy+destroy", ours, "std::shared_ptr", theirs});
+}
+
+void benchLog(std::vector<Result>& results) {
+    using log_component::Log;
+    const size_t n = 2000000;
+    const std::string message = "Processing item 123456";
+    Log& log = Log::getInstance();
+    // Сохранение каждого сообщения: фильтры уровня выключены
+    log.setPolicy(Log::NORMAL, Log::Policy{});
+    double ours = measure(n, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) log.message(Log::NORMAL, message);
+    });
+
+    // Аналог: последние 10 записей в std::deque
+    struct Entry {
+        std::time_t time;
+        int level;
+        std::string message;
+    };
+    std::deque<Entry> entries;
+    double theirs = measure(n, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            entries.push_back({std::time(nullptr), 0, message});
+            if (entries.size() > 10) entries.pop_front();
+        }
+    });
+    results.push_back({"Log", "message", ours, "std::deque ring of 10", theirs});
+
+    // Шторм разных сообщений с одного места вызова: почти все отбрасывает
+    // token bucket, в лог попадают сводки
+    std::vector<std::string> storm = makeIds("Processing item ", 1024);
+    log.setPolicy(Log::NORMAL, Log::Policy{1.0, 10, 5, 1.0});
+    double filtered = measure(n, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) log.message(Log::NORMAL, storm[i % storm.size()]);
+    });
+    double unfiltered = measure(n, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            entries.push_back({std::time(nullptr), 0, storm[i % storm.size()]});
+            if (entries.size() > 10) entries.pop_front();
+        }
+    });
+    results.push_back({"Log", "message storm (rate-limited)", filtered, "std::deque ring of 10", unfiltered});
+}
+
+void benchTypeMap(std::vector<Result>& results) {
+    const size_t n = 5000000;
+    type_map_component::TypeMap<int, double, std::string> map;
+    std::unordered_map<std::type_index, std::any> standard;
+
+    double oursSet = measure(n, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) map.addValue<int>(static_cast<int>(i));
+    });
+    double theirsSet = measure(n, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) standard[std::type_index(typeid(int))] = static_cast<int>(i);
+    });
+    results.push_back({"TypeMap", "set", oursSet, "std::unordered_map<type_index, any>", theirsSet});
+
+    double oursGet = measure(n, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) keep(map.getValue<int>());
+    });
+    double theirsGet = measure(n, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) keep(std::any_cast<int>(standard.at(std::type_index(typeid(int)))));
+    });
+    results.push_back({"TypeMap", "get", oursGet, "std::unordered_map<type_index, any>", theirsGet});
+}
+
+void benchUsers(std::vector<Result>& results) {
+    using users_component::UserGroupManager;
+    const size_t n = 200000;
+    const auto userIds = makeIds("user", n);
+    const auto names = makeIds("name", n);
+    auto emails = makeIds("mail", n);
+    for (auto& email : emails) email += "@example.com";
+    const auto groupIds = makeIds("group", 100);
+
+    // Аналог: строки пользователя в unordered_map, группы - векторы указателей
+    struct PlainUser {
+        std::string name;
+        std::string email;
+        int age;
+        std::string group;
+    };
+    using PlainUsers = std::unordered_map<std::string, PlainUser>;
+    using PlainGroups = std::unordered_map<std::string, std::vector<PlainUser*>>;
+
+    std::unique_ptr<UserGroupManager> manager;
+    PlainUsers plainUsers;
+    PlainGroups plainGroups;
+    auto createAll = [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) manager->createUser(userIds[i], names[i], emails[i], 30);
+    };
+    auto plainCreateAll = [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) plainUsers.emplace(userIds[i], PlainUser{names[i], emails[i], 30, {}});
+    };
+
+    double ours = measure(n, [&] { manager = std::make_unique<UserGroupManager>(); }, createAll);
+    double theirs = measure(n, [&] { plainUsers = PlainUsers(); }, plainCreateAll);
+    results.push_back({"UserGroupManager", "createUser", ours, "std::unordered_map<string, struct>", theirs});
+
+    NullBuf nullBuf;
+    std::ostream null(&nullBuf);
+    ours = measure(n, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) manager->printUser(userIds[(i * 7919) % n], null);
+    });
+    theirs = measure(n, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            const PlainUser& user = plainUsers.at(userIds[(i * 7919) % n]);
+            null << "User ID: " << userIds[(i * 7919) % n] << ", Username: " << user.name << ", Email: "
+                 << user.email << ", Age: " << user.age << "\n";
+        }
+    });
+    results.push_back({"UserGroupManager", "printUser (lookup)", ours, "unordered_map::at + ostream", theirs});
+
+    ours = measure(n, [&] {
+        manager = std::make_unique<UserGroupManager>();
+        createAll(n);
+        for (const auto& group : groupIds) manager->createGroup(group);
+    }, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) manager->addUserToGroup(userIds[i], groupIds[i % groupIds.size()]);
+    });
+    theirs = measure(n, [&] {
+        plainUsers = PlainUsers();
+        plainGroups = PlainGroups();
+        plainCreateAll(n);
+        for (const auto& group : groupIds) plainGroups[group];
+    }, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            PlainUser& user = plainUsers.at(userIds[i]);
+            const std::string& group = groupIds[i % groupIds.size()];
+            plainGroups.at(group).push_back(&user);
+            user.group = group;
+        }
+    });
+    results.push_back({"UserGroupManager", "addUserToGroup", ours, "unordered_map + vector<T*>", theirs});
+}
+
+void benchProcessor(std::vector<Result>& results) {
+    using namespace builder_component;
+    const size_t n = 1000000;
+    ControlPointProcessor processor;
+    processor.reserve(n);
+    std::vector<std::unique_ptr<ControlPoint>> objects;
+    objects.reserve(n);
+    std::mt19937 rng(7);
+    for (size_t i = 0; i < n; ++i) {
+        std::string name = "КП " + std::to_string(i % 1000);
+        double lat = 55.0 + (i % 1000) * 1e-4;
+        double lon = 37.0 + (i % 1000) * 1e-4;
+        bool mandatory = rng() % 3 == 0;
+        double penalty = mandatory ? 0.0 : (rng() % 50) / 10.0;
+        processor.addControlPoint(name, lat, lon, penalty, mandatory);
+        if (mandatory) {
+            objects.push_back(std::make_unique<MandatoryControlPoint>(name, lat, lon));
+        } else {
+            objects.push_back(std::make_unique<OptionalControlPoint>(name, lat, lon, penalty));
+        }
+    }
+
+    // buildResult печатает итог - на время замера std::cout выключен
+    NullBuf nullBuf;
+    std::streambuf* saved = std::cout.rdbuf(&nullBuf);
+    double ours = measure(1, [&](size_t) {
+        PenaltyStatisticsBuilder statistics;
+        processor.process(statistics);
+    }) / n;
+    std::cout.rdbuf(saved);
+
+    // Аналог: вектор полиморфных объектов и виртуальные вызовы на каждый пункт
+    double theirs = measure(1, [&](size_t) {
+        double total = 0;
+        size_t skipped = 0;
+        for (const auto& cp : objects) {
+            if (!cp->isMandatory()) {
+                total += cp->getPenalty();
+                ++skipped;
+            }
+        }
+        keep(total);
+        keep(skipped);
+    }) / n;
+    results.push_back({"ControlPointProcessor", "process (statistics, per point)", ours,
+                       "vector<unique_ptr<ControlPoint>> loop", theirs});
+}
+
+void benchConstArray(std::vector<Result>& results) {
+    for (size_t size : {16, 1000}) {
+        const size_t n = size < 100 ? 10000000 : 1000000;
+        double ours = measure(n, [&](size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                const_array_component::ca::ConstArray<int> array(size, static_cast<int>(i));
+                keep(array[size - 1]);
+            }
+        });
+        double theirs = measure(n, [&](size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                std::vector<int> vector(size, static_cast<int>(i));
+                keep(vector[size - 1]);
+            }
+        });
+        results.push_back({"ConstArray", "construct n=" + std::to_string(size), ours, "std::vector", theirs});
+    }
+}
+
+// Сортировка векторов ConstArray и MyShared: ca::sort переставляет элементы
+// точками настройки ca::swap/ca::relocate (friend swap ConstArray, memcpy для
+// тривиально переносимого MyShared), std::sort - перемещениями
+template <typename T, typename Less>
+void benchSortOf(std::vector<Result>& results, const char* component, const std::vector<T>& source, Less less) {
+    std::vector<T> items;
+    auto prepare = [&] { items = source; };
+    double ours = measure(source.size(), prepare, [&](size_t) {
+        const_array_component::ca::sort(items.begin(), items.end(), less);
+        keep(items.front());
+    });
+    double theirs = measure(source.size(), prepare, [&](size_t) {
+        std::sort(items.begin(), items.end(), less);
+        keep(items.front());
+    });
+    results.push_back({component, "sort n=" + std::to_string(source.size()) + " (per element)", ours,
+                       "std::sort", theirs});
+}
+
+void benchSort(std::vector<Result>& results) {
+    using const_array_component::ca::ConstArray;
+    using shared_ptr_component::MyShared;
+    const size_t n = 200000;
+    std::mt19937 random(42);
+
+    std::vector<ConstArray<int>> arrays;
+    arrays.reserve(n);
+    for (size_t i = 0; i < n; ++i) arrays.emplace_back(1 + random() % 32, static_cast<int>(random()));
+    benchSortOf(results, "ConstArray", arrays, [](const ConstArray<int>& a, const ConstArray<int>& b) {
+        return a[0] < b[0];
+    });
+
+    MyShared<int>::trace = false;
+    std::vector<MyShared<int>> shared;
+    shared.reserve(n);
+    for (size_t i = 0; i < n; ++i) shared.emplace_back(new int(static_cast<int>(random())));
+    benchSortOf(results, "MyShared", shared, [](const MyShared<int>& a, const MyShared<int>& b) {
+        return *a < *b;
+    });
+}
+
+void writeJsonString(std::ostream& out, std::string_view text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\';
+        out << c;
+    }
+    out << '"';
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results) {
+    char timestamp[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    out << std::setprecision(4) << std::fixed;
+    out << "{\n  \"timestamp\": \"" << timestamp << "\",\n  \"compiler\": ";
+    writeJsonString(out, __VERSION__);
+    out << ",\n  \"repeats\": " << REPEATS << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"component\": ";
+        writeJsonString(out, r.component);
+        out << ", \"operation\": ";
+        writeJsonString(out, r.operation);
+        out << ", \"ns_per_op\": " << r.nsPerOp << ", \"ops_per_sec\": " << 1e9 / r.nsPerOp
+            << ", \"baseline\": ";
+        writeJsonString(out, r.baseline);
+        out << ", \"baseline_ns_per_op\": " << r.baselineNsPerOp
+            << ", \"speedup\": " << r.baselineNsPerOp / r.nsPerOp << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string outPath;
+    std::string filter;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--out") == 0) outPath = argv[i + 1];
+        else if (std::strcmp(argv[i], "--filter") == 0) filter = argv[i + 1];
+    }
+
+    const std::pair<const char*, void (*)(std::vector<Result>&)> suites[] = {
+        {"MyShared", benchMyShared},
+        {"Log", benchLog},
+        {"TypeMap", benchTypeMap},
+        {"UserGroupManager", benchUsers},
+        {"ControlPointProcessor", benchProcessor},
+        {"ConstArray", benchConstArray},
+        {"sort", benchSort},
+    };
+    std::vector<Result> results;
+    for (const auto& [name, run] : suites) {
+        if (filter.empty() || std::string_view(name).find(filter) != std::string_view::npos) {
+            std::cerr << "running " << name << "...\n";
+            run(results);
+        }
+    }
+
+    if (outPath.empty()) {
+        writeJson(std::cout, results);
+        return 0;
+    }
+    std::ofstream file(outPath, std::ios::trunc);
+    writeJson(file, results);
+    if (!file) {
+        std::cerr << "Cannot write " << outPath << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -4,6 +4,37 @@
 #include <memory>
 #include <iomanip>
 #include <utility>
+#include <span>
+#include <deque>
+#include <cstdint>
+#include <string_view>
+#include <stdexcept>
+#include <unordered_map>
+#include <bit>
+#include <limits>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cmath>
+#include <charconv>
+#include <fstream>
+#include <tuple>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 // Базовый класс контрольного пункта
 class ControlPoint {
@@ -15,10 +46,14 @@ protected:
 public:
     ControlPoint(const std::string& name, double lat, double lon)
         : name(name), latitude(lat), longitude(lon) {
-        if (lat < -90.0 || lat > 90.0 || lon < -180.0 || lon > 180.0) {
+        if (!validCoordinates(lat, lon)) {
             throw std::invalid_argument("Invalid coordinates");
         }
     }
+
+    static bool validCoordinates(double lat, double lon) {
+        return lat >= -90.0 && lat <= 90.0 && lon >= -180.0 && lon <= 180.0;
+    }
     
     virtual ~ControlPoint() = default;
     
@@ -31,7 +66,7 @@ public:
 };
 
 // Обязательный контрольный пункт
-class MandatoryControlPoint : public ControlPoint {
+class MandatoryControlPoint final : public ControlPoint {
 public:
     MandatoryControlPoint(const std::string& name, double lat, double lon)
         : ControlPoint(name, lat, lon) {}
@@ -41,7 +76,7 @@ public:
 };
 
 // Необязательный контрольный пункт
-class OptionalControlPoint : public ControlPoint {
+class OptionalControlPoint final : public ControlPoint {
     double penalty;
     
 public:
@@ -50,73 +85,399 @@ public:
         if (penalty < 0) {
             throw std::invalid_argument("Penalty cannot be negative");
         }
+        if (!std::isfinite(penalty)) {
+            throw std::invalid_argument("Penalty must be finite");
+        }
     }
     
     double getPenalty() const override { return penalty; }
     bool isMandatory() const override { return false; }
 };
 
-// Абстрактный строитель
+// Таблица названий: каждое название хранится один раз, пункты ссылаются на него по номеру
+class NameTable {
+    std::deque<std::string> names;  // deque не перемещает элементы при росте
+    std::unordered_map<std::string_view, std::uint32_t> ids;
+
+public:
+    std::uint32_t intern(std::string_view name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        std::uint32_t id = static_cast<std::uint32_t>(names.size());
+        names.emplace_back(name);
+        ids.emplace(names.back(), id);
+        return id;
+    }
+
+    std::string_view name(std::uint32_t id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+};
+
+// Контрольный пункт в колоночном хранилище: значение без виртуальных вызовов
+struct ControlPointView {
+    std::string_view name;
+    double latitude;
+    double longitude;
+    double penalty;
+    bool mandatory;
+
+    std::string_view getName() const { return name; }
+    double getLatitude() const { return latitude; }
+    double getLongitude() const { return longitude; }
+    double getPenalty() const { return penalty; }
+    bool isMandatory() const { return mandatory; }
+};
+
+// Непрерывный участок колонок процессора. Признак обязательности хранится
+// битовой маской: бит (bitOffset + i) слова mandatoryBits относится к пункту i
+struct ControlPointSpan {
+    std::span<const double> latitudes;
+    std::span<const double> longitudes;
+    std::span<const double> penalties;  // у обязательных пунктов штраф 0
+    std::span<const std::uint32_t> nameIds;
+    const std::uint64_t* mandatoryBits = nullptr;
+    size_t bitOffset = 0;
+    const NameTable* names = nullptr;
+
+    size_t size() const { return penalties.size(); }
+
+    bool isMandatory(size_t i) const {
+        size_t bit = bitOffset + i;
+        return (mandatoryBits[bit / 64] >> (bit % 64)) & 1;
+    }
+
+    ControlPointView operator[](size_t i) const {
+        return {names->name(nameIds[i]), latitudes[i], longitudes[i], penalties[i], isMandatory(i)};
+    }
+
+    // 64 бита маски, начиная с пункта i (биты за концом участка не определены)
+    std::uint64_t mandatoryWord(size_t i) const {
+        size_t bit = bitOffset + i;
+        size_t word = bit / 64;
+        size_t shift = bit % 64;
+        std::uint64_t value = mandatoryBits[word] >> shift;
+        size_t lastWord = (bitOffset + size() - 1) / 64;
+        if (shift != 0 && word + 1 <= lastWord) {
+            value |= mandatoryBits[word + 1] << (64 - shift);
+        }
+        return value;
+    }
+
+    // Количество обязательных пунктов: popcount по словам маски
+    size_t countMandatory() const {
+        size_t first = bitOffset;
+        size_t last = bitOffset + size();
+        if (first == last) return 0;
+        size_t firstWord = first / 64;
+        size_t lastWord = (last - 1) / 64;
+        auto wordBits = [&](size_t w) {
+            std::uint64_t word = mandatoryBits[w];
+            if (w == firstWord) word &= ~std::uint64_t{0} << (first % 64);
+            if (w == lastWord && last % 64 != 0) word &= ~std::uint64_t{0} >> (64 - last % 64);
+            return static_cast<size_t>(std::popcount(word));
+        };
+        size_t count = 0;
+        for (size_t w = firstWord; w <= lastWord; ++w) count += wordBits(w);
+        return count;
+    }
+
+    // Сумма штрафов. Четыре независимых аккумулятора разрывают цепочку
+    // зависимостей и позволяют компилятору векторизовать цикл
+    double sumPenalties() const {
+        const double* p = penalties.data();
+        size_t n = penalties.size();
+        double acc[4] = {0.0, 0.0, 0.0, 0.0};
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            acc[0] += p[i];
+            acc[1] += p[i + 1];
+            acc[2] += p[i + 2];
+            acc[3] += p[i + 3];
+        }
+        for (; i < n; ++i) acc[0] += p[i];
+        return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    }
+};
+
+// Простой пул потоков. parallelFor раздаёт номера задач 0..count-1 рабочим
+// потокам и вызывающему потоку и возвращается после выполнения всех задач
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+        for (size_t i = 1; i < threads; ++i) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    void parallelFor(size_t count, const std::function<void(size_t)>& task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = &task;
+            taskCount = count;
+            next = 0;
+            active = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+        runTasks(task, count);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return active == 0; });
+        current = nullptr;
+    }
+
+private:
+    void runTasks(const std::function<void(size_t)>& task, size_t count) {
+        for (size_t i = next++; i < count; i = next++) {
+            task(i);
+        }
+    }
+
+    void workerLoop() {
+        size_t seen = 0;
+        while (true) {
+            const std::function<void(size_t)>* task;
+            size_t count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                task = current;
+                count = taskCount;
+            }
+            runTasks(*task, count);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--active == 0) done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* current = nullptr;
+    size_t taskCount = 0;
+    std::atomic<size_t> next{0};
+    size_t active = 0;
+    size_t generation = 0;
+    bool stopping = false;
+};
+
+// Абстрактный строитель. Процессор передаёт пункты непрерывными участками;
+// по умолчанию участок разбирается на отдельные пункты
 class ControlPointBuilder {
 public:
     virtual ~ControlPointBuilder() = default;
-    virtual void addControlPoint(const ControlPoint& cp) = 0;
+    virtual void addControlPoint(const ControlPointView& cp) = 0;
+    virtual void addControlPoints(const ControlPointSpan& points) {
+        for (size_t i = 0; i < points.size(); ++i) {
+            addControlPoint(points[i]);
+        }
+    }
     virtual void buildResult() = 0;
+
+    // Для параллельной обработки: clone создаёт пустой строитель с теми же
+    // настройками, merge добавляет результат такого строителя, обработавшего
+    // следующий по порядку участок. Строитель без clone обрабатывается целиком
+    // в вызывающем потоке
+    virtual std::unique_ptr<ControlPointBuilder> clone() const { return nullptr; }
+    virtual void merge(const ControlPointBuilder& part) { (void)part; }
 };
 
-// Строитель для текстового вывода
-class TextListBuilder : public ControlPointBuilder {
-    std::vector<std::reference_wrapper<const ControlPoint>> points;
+// Строитель для текстового вывода. Строки таблицы форматируются сразу при
+// добавлении пункта (числа через std::to_chars) в один непрерывный буфер,
+// поэтому строитель не держит ссылок на пункты процессора. Номер строки
+// дописывается при выводе - так части от разных потоков объединяются простым
+// копированием. Вывод идёт крупными блоками в поток или в файл через mmap
+class TextListBuilder final : public ControlPointBuilder {
+    std::string rows;               // строки без номера: " | Название | (...) | штраф\n"
+    std::vector<size_t> rowEnds;    // конец каждой строки в rows
+    std::ostream& out;
+
+    static constexpr std::string_view HEADER =
+        "\nСписок контрольных пунктов:\n"
+        "==================================================\n"
+        " № | Название          | Координаты           | Штраф\n"
+        "--------------------------------------------------\n";
+    static constexpr std::string_view FOOTER =
+        "==================================================\n";
+    static constexpr size_t BLOCK_SIZE = 1 << 20;
     
 public:
-    void addControlPoint(const ControlPoint& cp) override {
-        points.push_back(cp);
+    explicit TextListBuilder(std::ostream& out = std::cout) : out(out) {}
+
+    void addControlPoint(const ControlPointView& cp) override {
+        // Штраф сверху не ограничен: в fixed-записи у double до max_exponent10 + 1
+        // цифр целой части, плюс знак, точка и дробная часть
+        char number[std::numeric_limits<double>::max_exponent10 + 16];
+        rows += " | ";
+        // Название выравнивается по ширине 17 байт, как setw(17)
+        rows += cp.getName();
+        if (cp.getName().size() < 17) rows.append(17 - cp.getName().size(), ' ');
+        rows += " | (";
+        rows.append(number, std::to_chars(number, number + sizeof(number), cp.getLatitude(),
+                                          std::chars_format::fixed, 6).ptr);
+        rows += ", ";
+        rows.append(number, std::to_chars(number, number + sizeof(number), cp.getLongitude(),
+                                          std::chars_format::fixed, 6).ptr);
+        rows += ") | ";
+        if (cp.isMandatory()) {
+            rows += "незачёт СУ";
+        } else {
+            rows.append(number, std::to_chars(number, number + sizeof(number), cp.getPenalty(),
+                                              std::chars_format::fixed, 1).ptr);
+            rows += " ч";
+        }
+        rows += '\n';
+        rowEnds.push_back(rows.size());
+    }
+
+    void addControlPoints(const ControlPointSpan& span) override {
+        rows.reserve(rows.size() + span.size() * 64);
+        rowEnds.reserve(rowEnds.size() + span.size());
+        ControlPointBuilder::addControlPoints(span);
+    }
+
+    std::unique_ptr<ControlPointBuilder> clone() const override {
+        return std::make_unique<TextListBuilder>(out);
+    }
+
+    // part создан нашим clone, поэтому тип известен
+    void merge(const ControlPointBuilder& part) override {
+        const auto& other = static_cast<const TextListBuilder&>(part);
+        size_t shift = rows.size();
+        rows += other.rows;
+        for (size_t end : other.rowEnds) {
+            rowEnds.push_back(end + shift);
+        }
     }
     
+    // Вывод в поток блоками по BLOCK_SIZE байт
     void buildResult() override {
-        std::cout << "\nСписок контрольных пунктов:\n";
-        std::cout << "==================================================\n";
-        std::cout << " № | Название          | Координаты           | Штраф\n";
-        std::cout << "--------------------------------------------------\n";
-        
-        int index = 1;
-        for (const auto& cp_ref : points) {
-            const ControlPoint& cp = cp_ref.get();
-            
-            // Форматируем вывод
-            std::cout << std::setw(2) << std::right << index++ << " | ";
-            std::cout << std::setw(17) << std::left << cp.getName() << " | ";
-            
-            // Координаты с фиксированной точностью
-            std::cout << "(" << std::fixed << std::setprecision(6) 
-                      << cp.getLatitude() << ", " 
-                      << cp.getLongitude() << ") | ";
-            
-            // Вывод штрафа или отметки
-            if (cp.isMandatory()) {
-                std::cout << "незачёт СУ";
-            } else {
-                std::cout << std::setprecision(1) << cp.getPenalty() << " ч";
+        std::vector<char> block(BLOCK_SIZE);
+        size_t used = 0;
+        auto flush = [&] {
+            out.write(block.data(), static_cast<std::streamsize>(used));
+            used = 0;
+        };
+        auto append = [&](std::string_view text) {
+            if (block.size() - used < text.size()) flush();
+            if (text.size() > block.size()) {
+                out.write(text.data(), static_cast<std::streamsize>(text.size()));
+                return;
             }
-            
-            std::cout << "\n";
+            std::memcpy(block.data() + used, text.data(), text.size());
+            used += text.size();
+        };
+
+        append(HEADER);
+        for (size_t i = 0; i < rowEnds.size(); ++i) {
+            if (block.size() - used < 24) flush();
+            used = renderIndex(i, block.data() + used) - block.data();
+            append(row(i));
+        }
+        append(FOOTER);
+        flush();
+    }
+
+    // Запись отчёта в файл через mmap: размер известен заранее, строки
+    // копируются прямо в отображение файла
+    void writeToFile(const std::string& path) const {
+        size_t total = HEADER.size() + rows.size() + FOOTER.size();
+        for (size_t i = 0; i < rowEnds.size(); ++i) {
+            total += indexWidth(i + 1);
+        }
+
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot create " + path);
+        }
+        if (ftruncate(fd, static_cast<off_t>(total)) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot resize " + path);
+        }
+        void* mapped = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("Cannot map " + path);
+        }
+
+        char* dst = static_cast<char*>(mapped);
+        dst = std::copy(HEADER.begin(), HEADER.end(), dst);
+        for (size_t i = 0; i < rowEnds.size(); ++i) {
+            dst = renderIndex(i, dst);
+            std::string_view text = row(i);
+            dst = std::copy(text.begin(), text.end(), dst);
         }
-        std::cout << "==================================================\n";
+        std::copy(FOOTER.begin(), FOOTER.end(), dst);
+        munmap(mapped, total);
+    }
+
+private:
+    std::string_view row(size_t i) const {
+        size_t begin = i == 0 ? 0 : rowEnds[i - 1];
+        return std::string_view(rows).substr(begin, rowEnds[i] - begin);
+    }
+
+    // Номер строки выравнивается вправо по ширине 2, как setw(2)
+    static size_t indexWidth(size_t index) {
+        size_t digits = 1;
+        for (size_t v = index; v >= 10; v /= 10) ++digits;
+        return std::max<size_t>(2, digits);
+    }
+
+    static char* renderIndex(size_t i, char* dst) {
+        size_t index = i + 1;
+        if (index < 10) *dst++ = ' ';
+        return std::to_chars(dst, dst + 20, index).ptr;
     }
 };
 
 // Строитель для подсчёта штрафов
-class PenaltyCalculatorBuilder : public ControlPointBuilder {
+class PenaltyCalculatorBuilder final : public ControlPointBuilder {
     double totalPenalty = 0.0;
     int skippedPoints = 0;
     
 public:
-    void addControlPoint(const ControlPoint& cp) override {
+    void addControlPoint(const ControlPointView& cp) override {
         if (!cp.isMandatory()) {
             totalPenalty += cp.getPenalty();
             skippedPoints++;
         }
     }
+
+    // Штраф обязательных пунктов равен 0, поэтому сумма берётся по всей колонке
+    void addControlPoints(const ControlPointSpan& points) override {
+        totalPenalty += points.sumPenalties();
+        skippedPoints += static_cast<int>(points.size() - points.countMandatory());
+    }
+
+    std::unique_ptr<ControlPointBuilder> clone() const override {
+        return std::make_unique<PenaltyCalculatorBuilder>();
+    }
+
+    void merge(const ControlPointBuilder& part) override {
+        const auto& other = static_cast<const PenaltyCalculatorBuilder&>(part);
+        totalPenalty += other.totalPenalty;
+        skippedPoints += other.skippedPoints;
+    }
     
     void buildResult() override {
         std::cout << "\nСтатистика по необязательным КП:\n";
@@ -128,24 +489,1451 @@ public:
     }
 };
 
-// Директор - управляет процессом построения
+// Статистика по необязательным пунктам за один проход по колонкам: сумма и
+// среднее штрафа, количество, минимум/максимум и гистограмма. Участок
+// обрабатывается блоками по 64 пункта - одно слово маски на блок; внутри
+// блока при сборке с AVX2 используются векторные операции по 4 значения
+class PenaltyStatisticsBuilder final : public ControlPointBuilder {
+    double bucketWidth;
+    std::vector<size_t> buckets;
+    double totalPenalty = 0.0;
+    size_t skippedPoints = 0;
+    double minPenalty = std::numeric_limits<double>::infinity();
+    double maxPenalty = -std::numeric_limits<double>::infinity();
+
+public:
+    // Гистограмма: bucketCount корзин шириной bucketWidth, последняя - "и больше"
+    explicit PenaltyStatisticsBuilder(double bucketWidth = 0.5, size_t bucketCount = 10)
+        : bucketWidth(bucketWidth), buckets(bucketCount, 0) {
+        if (bucketWidth <= 0 || bucketCount == 0) {
+            throw std::invalid_argument("Invalid histogram parameters");
+        }
+    }
+
+    void addControlPoint(const ControlPointView& cp) override {
+        if (!cp.isMandatory()) {
+            addOptional(cp.getPenalty());
+        }
+    }
+
+    void addControlPoints(const ControlPointSpan& points) override {
+        const double* penalties = points.penalties.data();
+        size_t n = points.size();
+#if defined(__AVX2__)
+        __m256d sum = _mm256_setzero_pd();
+        __m256d minV = _mm256_set1_pd(minPenalty);
+        __m256d maxV = _mm256_set1_pd(maxPenalty);
+        const __m256d posInf = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+        const __m256d negInf = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+        const __m256d inverseWidth = _mm256_set1_pd(1.0 / bucketWidth);
+        const __m256d lastBucket = _mm256_set1_pd(static_cast<double>(buckets.size() - 1));
+        const __m256i laneBits = _mm256_set_epi64x(8, 4, 2, 1);
+        alignas(16) std::int32_t index[4];
+#endif
+        for (size_t block = 0; block < n; block += 64) {
+            size_t len = std::min<size_t>(64, n - block);
+            std::uint64_t lenMask = len == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << len) - 1;
+            std::uint64_t optional = ~points.mandatoryWord(block) & lenMask;
+            skippedPoints += static_cast<size_t>(std::popcount(optional));
+            const double* p = penalties + block;
+            size_t j = 0;
+#if defined(__AVX2__)
+            for (; j + 4 <= len; j += 4) {
+                __m256d v = _mm256_loadu_pd(p + j);
+                // Штраф обязательных пунктов равен 0 - в сумму их можно не маскировать
+                sum = _mm256_add_pd(sum, v);
+
+                long long lanes = static_cast<long long>((optional >> j) & 0xF);
+                if (lanes == 0) continue;
+                __m256i bits = _mm256_and_si256(_mm256_set1_epi64x(lanes), laneBits);
+                __m256d mask = _mm256_castsi256_pd(_mm256_cmpeq_epi64(bits, laneBits));
+                minV = _mm256_min_pd(minV, _mm256_blendv_pd(posInf, v, mask));
+                maxV = _mm256_max_pd(maxV, _mm256_blendv_pd(negInf, v, mask));
+
+                __m256d bucket = _mm256_min_pd(_mm256_mul_pd(v, inverseWidth), lastBucket);
+                _mm_store_si128(reinterpret_cast<__m128i*>(index), _mm256_cvttpd_epi32(bucket));
+                for (int k = 0; k < 4; ++k) {
+                    if (lanes & (1 << k)) ++buckets[index[k]];
+                }
+            }
+#endif
+            for (; j < len; ++j) {
+                if ((optional >> j) & 1) {
+                    addOptionalUncounted(p[j]);
+                }
+            }
+        }
+#if defined(__AVX2__)
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, sum);
+        totalPenalty += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        // minPenalty/maxPenalty уже учитывают скалярные хвосты блоков
+        _mm256_store_pd(lanes, minV);
+        minPenalty = std::min(minPenalty, std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3])));
+        _mm256_store_pd(lanes, maxV);
+        maxPenalty = std::max(maxPenalty, std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3])));
+#endif
+    }
+
+    std::unique_ptr<ControlPointBuilder> clone() const override {
+        return std::make_unique<PenaltyStatisticsBuilder>(bucketWidth, buckets.size());
+    }
+
+    void merge(const ControlPointBuilder& part) override {
+        const auto& other = static_cast<const PenaltyStatisticsBuilder&>(part);
+        totalPenalty += other.totalPenalty;
+        skippedPoints += other.skippedPoints;
+        minPenalty = std::min(minPenalty, other.minPenalty);
+        maxPenalty = std::max(maxPenalty, other.maxPenalty);
+        for (size_t b = 0; b < buckets.size(); ++b) {
+            buckets[b] += other.buckets[b];
+        }
+    }
+
+    size_t getSkippedPoints() const { return skippedPoints; }
+    double getTotalPenalty() const { return totalPenalty; }
+    double getMeanPenalty() const { return skippedPoints ? totalPenalty / skippedPoints : 0.0; }
+    double getMinPenalty() const { return skippedPoints ? minPenalty : 0.0; }
+    double getMaxPenalty() const { return skippedPoints ? maxPenalty : 0.0; }
+    const std::vector<size_t>& getHistogram() const { return buckets; }
+
+    void buildResult() override {
+        std::cout << "\nРаспределение штрафов необязательных КП:\n";
+        std::cout << "----------------------------------\n";
+        std::cout << "Количество пропущенных КП: " << skippedPoints << "\n";
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Суммарный штраф: " << totalPenalty << " часов\n";
+        std::cout << "Средний штраф: " << std::setprecision(2) << getMeanPenalty() << " ч"
+                  << std::setprecision(1) << ", мин " << getMinPenalty()
+                  << " ч, макс " << getMaxPenalty() << " ч\n";
+        for (size_t b = 0; b < buckets.size(); ++b) {
+            std::cout << "  [" << b * bucketWidth << "; ";
+            if (b + 1 < buckets.size()) {
+                std::cout << (b + 1) * bucketWidth << "): ";
+            } else {
+                std::cout << "...): ";
+            }
+            std::cout << buckets[b] << "\n";
+        }
+        std::cout << "----------------------------------\n";
+    }
+
+private:
+    size_t bucketOf(double penalty) const {
+        double bucket = std::min(penalty / bucketWidth, static_cast<double>(buckets.size() - 1));
+        return static_cast<size_t>(bucket);
+    }
+
+    void addOptional(double penalty) {
+        ++skippedPoints;
+        addOptionalUncounted(penalty);
+    }
+
+    // Учёт штрафа без увеличения счётчика (в пакетном пути он считается по маске)
+    void addOptionalUncounted(double penalty) {
+        totalPenalty += penalty;
+        minPenalty = std::min(minPenalty, penalty);
+        maxPenalty = std::max(maxPenalty, penalty);
+        ++buckets[bucketOf(penalty)];
+    }
+};
+
+// Директор - управляет процессом построения. Пункты хранятся по колонкам:
+// координаты, штрафы, битовая маска обязательности и номера названий
 class ControlPointProcessor {
-    std::vector<std::unique_ptr<ControlPoint>> controlPoints;
+    std::vector<double> latitudes;
+    std::vector<double> longitudes;
+    std::vector<double> penalties;
+    std::vector<std::uint64_t> mandatoryBits;
+    std::vector<std::uint32_t> nameIds;
+    NameTable names;
     
 public:
     void addControlPoint(std::unique_ptr<ControlPoint> cp) {
-        controlPoints.push_back(std::move(cp));
+        append(cp->getName(), cp->getLatitude(), cp->getLongitude(),
+               cp->isMandatory() ? 0.0 : cp->getPenalty(), cp->isMandatory());
     }
+
+    // Добавление без создания объекта ControlPoint (с той же проверкой значений)
+    void addControlPoint(std::string_view name, double lat, double lon, double penalty, bool mandatory) {
+        if (!ControlPoint::validCoordinates(lat, lon)) {
+            throw std::invalid_argument("Invalid coordinates");
+        }
+        if (penalty < 0) {
+            throw std::invalid_argument("Penalty cannot be negative");
+        }
+        if (!std::isfinite(penalty)) {
+            throw std::invalid_argument("Penalty must be finite");
+        }
+        append(name, lat, lon, mandatory ? 0.0 : penalty, mandatory);
+    }
+
+    // Добавление без проверки: загрузчик проверяет значения пакетно и сам
+    // отбрасывает неверные строки
+    void addControlPointUnchecked(std::string_view name, double lat, double lon, double penalty, bool mandatory) {
+        append(name, lat, lon, mandatory ? 0.0 : penalty, mandatory);
+    }
+
+    // Двоичный формат для быстрой повторной загрузки: заголовок, таблица
+    // названий, затем колонки как есть (порядок байтов машины)
+    void saveBinary(const std::string& path) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Cannot create " + path);
+        }
+        std::uint64_t header[3] = {BINARY_MAGIC, size(), names.size()};
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        for (std::uint32_t id = 0; id < names.size(); ++id) {
+            std::string_view name = names.name(id);
+            std::uint32_t length = static_cast<std::uint32_t>(name.size());
+            file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            file.write(name.data(), static_cast<std::streamsize>(name.size()));
+        }
+        auto writeColumn = [&file](const auto& column) {
+            file.write(reinterpret_cast<const char*>(column.data()),
+                       static_cast<std::streamsize>(column.size() * sizeof(column[0])));
+        };
+        writeColumn(latitudes);
+        writeColumn(longitudes);
+        writeColumn(penalties);
+        writeColumn(nameIds);
+        writeColumn(mandatoryBits);
+        if (!file.flush()) {
+            throw std::runtime_error("Cannot write " + path);
+        }
+    }
+
+    // Загрузка двоичного файла: колонки копируются из отображения целиком
+    void loadBinary(const std::string& path);
+
+    void reserve(size_t n) {
+        latitudes.reserve(n);
+        longitudes.reserve(n);
+        penalties.reserve(n);
+        nameIds.reserve(n);
+        mandatoryBits.reserve((n + 63) / 64);
+    }
+
+    size_t size() const { return penalties.size(); }
+
+    // Участок [begin, end) в виде непрерывных колонок
+    ControlPointSpan points(size_t begin, size_t end) const {
+        ControlPointSpan span;
+        span.latitudes = std::span<const double>(latitudes).subspan(begin, end - begin);
+        span.longitudes = std::span<const double>(longitudes).subspan(begin, end - begin);
+        span.penalties = std::span<const double>(penalties).subspan(begin, end - begin);
+        span.nameIds = std::span<const std::uint32_t>(nameIds).subspan(begin, end - begin);
+        span.mandatoryBits = mandatoryBits.data();
+        span.bitOffset = begin;
+        span.names = &names;
+        return span;
+    }
+
+    ControlPointSpan points() const { return points(0, size()); }
     
     void process(ControlPointBuilder& builder) const {
-        for (const auto& cp : controlPoints) {
-            builder.addControlPoint(*cp);
-        }
+        builder.addControlPoints(points());
         builder.buildResult();
     }
+
+    // Обработка несколькими строителями за один проход: пункты делятся на
+    // непрерывные диапазоны по числу потоков пула, каждый диапазон подаётся
+    // участками по CHUNK пунктов всем копиям строителей этого потока, пока
+    // участок в кэше. Затем копии объединяются через merge в порядке диапазонов
+    template <typename... Builders>
+    void processAll(ThreadPool& pool, Builders&... builders) const {
+        ControlPointBuilder* targets[] = {&builders...};
+        processAll(pool, std::span<ControlPointBuilder* const>(targets));
+    }
+
+    void processAll(ThreadPool& pool, std::span<ControlPointBuilder* const> builders) const {
+        const size_t CHUNK = 16 * 1024;
+        // Границы диапазонов кратны 64, чтобы участки начинались со слова маски
+        size_t parts = std::max<size_t>(1, std::min(pool.size(), (size() + CHUNK - 1) / CHUNK));
+        size_t perPart = (size() / parts + 63) / 64 * 64;
+
+        std::vector<ControlPointBuilder*> parallel;
+        std::vector<ControlPointBuilder*> serial;
+        std::vector<std::vector<std::unique_ptr<ControlPointBuilder>>> clones(parts);
+        for (ControlPointBuilder* builder : builders) {
+            auto first = builder->clone();
+            if (!first) {
+                serial.push_back(builder);
+                continue;
+            }
+            parallel.push_back(builder);
+            clones[0].push_back(std::move(first));
+            for (size_t part = 1; part < parts; ++part) {
+                clones[part].push_back(builder->clone());
+            }
+        }
+
+        if (!parallel.empty()) {
+            pool.parallelFor(parts, [&](size_t part) {
+                size_t begin = std::min(size(), part * perPart);
+                size_t end = part + 1 == parts ? size() : std::min(size(), begin + perPart);
+                for (size_t chunk = begin; chunk < end; chunk += CHUNK) {
+                    ControlPointSpan span = points(chunk, std::min(end, chunk + CHUNK));
+                    for (auto& clone : clones[part]) {
+                        clone->addControlPoints(span);
+                    }
+                }
+            });
+            for (size_t i = 0; i < parallel.size(); ++i) {
+                for (size_t part = 0; part < parts; ++part) {
+                    parallel[i]->merge(*clones[part][i]);
+                }
+            }
+        }
+        for (ControlPointBuilder* builder : serial) {
+            builder->addControlPoints(points());
+        }
+        for (ControlPointBuilder* builder : builders) {
+            builder->buildResult();
+        }
+    }
+
+private:
+    static constexpr std::uint64_t BINARY_MAGIC = 0x3130535450435043ull;  // "CPCPTS01"
+
+    void append(std::string_view name, double lat, double lon, double penalty, bool mandatory) {
+        size_t index = size();
+        if (index % 64 == 0) mandatoryBits.push_back(0);
+        if (mandatory) mandatoryBits.back() |= std::uint64_t{1} << (index % 64);
+        latitudes.push_back(lat);
+        longitudes.push_back(lon);
+        penalties.push_back(penalty);
+        nameIds.push_back(names.intern(name));
+    }
 };
 
-int main() {
+// Списки типов (как в hw/TypeList.cpp; каждый файл - отдельная программа,
+// поэтому нужная часть повторена здесь)
+namespace TypeListUtils {
+
+template<typename... Types>
+struct TypeList {};
+
+template<typename TList, typename T>
+struct Contains;
+
+template<typename... Types, typename T>
+struct Contains<TypeList<Types...>, T> {
+    static constexpr bool value = (std::is_same_v<Types, T> || ...);
+};
+
+} // namespace TypeListUtils
+
+// Вызов строителя для пункта известного вида. Если у строителя есть
+// visit(const Kind&), вызывается он; иначе addControlPoint с видом пункта,
+// собранным из невиртуальных (final) методов вида. Для final-строителя
+// вызов прямой и встраивается: isMandatory() у вида - константа, и ветки
+// строителя для другого вида выбрасываются компилятором
+template <typename Builder, typename Kind>
+void visitControlPoint(Builder& builder, const Kind& point) {
+    if constexpr (requires { builder.visit(point); }) {
+        builder.visit(point);
+    } else {
+        bool mandatory = point.isMandatory();
+        builder.addControlPoint(ControlPointView{point.getName(), point.getLatitude(), point.getLongitude(),
+                                                 mandatory ? 0.0 : point.getPenalty(), mandatory});
+    }
+}
+
+// Процессор для закрытого набора видов пунктов, перечисленных в TypeList.
+// Пункты хранятся значениями в отдельном векторе для каждого вида, обход
+// для каждого вида и каждого строителя разворачивается при компиляции -
+// в цикле обработки нет косвенных переходов. Строители получают пункты по
+// видам в порядке списка, внутри вида - в порядке добавления; строителям,
+// которым важен общий порядок (TextListBuilder), нужен ControlPointProcessor
+template <typename Kinds>
+class StaticControlPointProcessor;
+
+template <typename... Kinds>
+class StaticControlPointProcessor<TypeListUtils::TypeList<Kinds...>> {
+    using KindList = TypeListUtils::TypeList<Kinds...>;
+    static_assert((std::is_final_v<Kinds> && ...), "point kinds must be final to be called without dispatch");
+
+    std::tuple<std::vector<Kinds>...> points;
+
+public:
+    template <typename Kind, typename... Args>
+    const Kind& addControlPoint(Args&&... args) {
+        static_assert(TypeListUtils::Contains<KindList, Kind>::value, "Kind is not in the list of point kinds");
+        return pointsOf<Kind>().emplace_back(std::forward<Args>(args)...);
+    }
+
+    template <typename Kind>
+    const std::vector<Kind>& pointsOf() const { return std::get<std::vector<Kind>>(points); }
+
+    template <typename Kind>
+    void reserve(size_t n) { pointsOf<Kind>().reserve(n); }
+
+    size_t size() const { return (pointsOf<Kinds>().size() + ...); }
+
+    // Подать все пункты строителям (без buildResult)
+    template <typename... Builders>
+    void visit(Builders&... builders) const {
+        (visitKind(pointsOf<Kinds>(), builders...), ...);
+    }
+
+    template <typename... Builders>
+    void process(Builders&... builders) const {
+        visit(builders...);
+        (builders.buildResult(), ...);
+    }
+
+private:
+    template <typename Kind>
+    std::vector<Kind>& pointsOf() { return std::get<std::vector<Kind>>(points); }
+
+    template <typename Kind, typename... Builders>
+    static void visitKind(const std::vector<Kind>& kindPoints, Builders&... builders) {
+        for (const Kind& point : kindPoints) {
+            (visitControlPoint(builders, point), ...);
+        }
+    }
+};
+
+using ControlPointKinds = TypeListUtils::TypeList<MandatoryControlPoint, OptionalControlPoint>;
+
+// Файл, отображённый в память только для чтения
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot stat " + path);
+        }
+        length = static_cast<size_t>(st.st_size);
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Cannot map " + path);
+            }
+            madvise(mapped, length, MADV_SEQUENTIAL);
+            bytes = static_cast<const char*>(mapped);
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (bytes) munmap(const_cast<char*>(bytes), length);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+};
+
+// Поиск ближайшей ',' или '\n': по 16 байт за шаг через SSE2
+const char* findDelimiter(const char* p, const char* end) {
+#if defined(__SSE2__)
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(block, comma), _mm_cmpeq_epi8(block, newline))));
+        if (mask) return p + std::countr_zero(mask);
+        p += 16;
+    }
+#endif
+    while (p < end && *p != ',' && *p != '\n') ++p;
+    return p;
+}
+
+// Загрузка пунктов из CSV "name,latitude,longitude,penalty,mandatory" (mandatory:
+// 1 или 0, у обязательных штраф можно не указывать; первая строка-заголовок,
+// начинающаяся с "name,", пропускается; кавычки в названиях не поддерживаются).
+// Файл читается через mmap блоками строк. Строки с ошибками не бросают
+// исключений, а пропускаются и попадают в отчёт
+class ControlPointLoader {
+public:
+    struct LoadError {
+        size_t line;
+        std::string message;
+    };
+
+    struct LoadReport {
+        size_t loaded = 0;
+        size_t rejected = 0;
+        std::vector<LoadError> errors;  // первые по номеру строки MAX_ERRORS ошибок
+    };
+
+    static constexpr size_t MAX_ERRORS = 100;
+
+    static LoadReport loadCsv(const std::string& path, ControlPointProcessor& processor) {
+        MappedFile file(path);
+        const char* p = file.data();
+        const char* end = p + file.size();
+        LoadReport report;
+        Block block;
+        size_t line = 1;
+
+        if (file.size() >= 5 && std::memcmp(p, "name,", 5) == 0) {
+            p = nextLine(p, end);
+            ++line;
+        }
+        // Оценка числа строк для резервирования колонок (строка ~ 40 байт)
+        processor.reserve(processor.size() + file.size() / 40);
+
+        while (p < end) {
+            const char* lineStart = p;
+            std::string_view fields[5];
+            size_t count = 0;
+            while (count < 5) {
+                const char* q = findDelimiter(p, end);
+                fields[count++] = std::string_view(p, static_cast<size_t>(q - p));
+                p = q;
+                if (p == end || *p == '\n') break;
+                ++p;
+            }
+            bool complete = count == 5 && (p == end || *p == '\n');
+            if (!complete) p = nextLine(p, end);
+            else if (p < end) ++p;
+
+            if (!fields[count - 1].empty() && fields[count - 1].back() == '\r') {
+                fields[count - 1].remove_suffix(1);
+            }
+            if (count == 1 && fields[0].empty()) {
+                ++line;  // пустая строка
+                continue;
+            }
+            if (!complete) {
+                reject(report, line, "expected 5 fields");
+            } else if (!block.parse(fields, line)) {
+                std::string_view text(lineStart, std::min<size_t>(p - lineStart, 80));
+                while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.remove_suffix(1);
+                reject(report, line, "cannot parse number in \"" + std::string(text) + "\"");
+            }
+            ++line;
+            if (block.size() == Block::CAPACITY) {
+                block.flush(processor, report);
+            }
+        }
+        block.flush(processor, report);
+        std::sort_heap(report.errors.begin(), report.errors.end(), byLine);
+        return report;
+    }
+
+private:
+    // Буфер разобранных строк: проверяется и добавляется в процессор пакетом
+    struct Block {
+        static constexpr size_t CAPACITY = 64 * 1024;
+
+        std::vector<std::string_view> names;
+        std::vector<double> lats, lons, penalties;
+        std::vector<std::uint8_t> mandatory;
+        std::vector<size_t> lines;
+        std::vector<std::uint8_t> valid;
+
+        size_t size() const { return names.size(); }
+
+        bool parse(const std::string_view (&fields)[5], size_t line) {
+            double lat, lon, penalty = 0.0;
+            bool isMandatory;
+            if (fields[4] == "1") isMandatory = true;
+            else if (fields[4] == "0") isMandatory = false;
+            else return false;
+            if (!parseDouble(fields[1], lat) || !parseDouble(fields[2], lon)) return false;
+            if (!(isMandatory && fields[3].empty()) && !parseDouble(fields[3], penalty)) return false;
+
+            names.push_back(fields[0]);
+            lats.push_back(lat);
+            lons.push_back(lon);
+            penalties.push_back(isMandatory ? 0.0 : penalty);
+            mandatory.push_back(isMandatory);
+            lines.push_back(line);
+            return true;
+        }
+
+        void flush(ControlPointProcessor& processor, LoadReport& report) {
+            size_t n = size();
+            // Проверка диапазонов без ветвлений - цикл векторизуется компилятором
+            valid.resize(n);
+            for (size_t i = 0; i < n; ++i) {
+                valid[i] = (lats[i] >= -90.0) & (lats[i] <= 90.0) &
+                           (lons[i] >= -180.0) & (lons[i] <= 180.0) &
+                           (penalties[i] >= 0.0) & (penalties[i] <= std::numeric_limits<double>::max());
+            }
+            for (size_t i = 0; i < n; ++i) {
+                if (valid[i]) {
+                    processor.addControlPointUnchecked(names[i], lats[i], lons[i], penalties[i], mandatory[i]);
+                    ++report.loaded;
+                } else if (!ControlPoint::validCoordinates(lats[i], lons[i])) {
+                    reject(report, lines[i], "Invalid coordinates");
+                } else {
+                    reject(report, lines[i], penalties[i] < 0 ? "Penalty cannot be negative" : "Penalty must be finite");
+                }
+            }
+            names.clear();
+            lats.clear();
+            lons.clear();
+            penalties.clear();
+            mandatory.clear();
+            lines.clear();
+        }
+    };
+
+    static bool parseDouble(std::string_view field, double& value) {
+        auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+        return result.ec == std::errc() && result.ptr == field.data() + field.size();
+    }
+
+    static const char* nextLine(const char* p, const char* end) {
+        const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+        return nl ? static_cast<const char*>(nl) + 1 : end;
+    }
+
+    static bool byLine(const LoadError& a, const LoadError& b) { return a.line < b.line; }
+
+    // Ошибки разбора записываются сразу, ошибки диапазонов - при сбросе блока,
+    // то есть не по порядку строк. Поэтому во время загрузки errors - куча по
+    // номеру строки: при переполнении вытесняется ошибка с наибольшим номером
+    static void reject(LoadReport& report, size_t line, std::string message) {
+        ++report.rejected;
+        if (report.errors.size() == MAX_ERRORS) {
+            if (line > report.errors.front().line) return;
+            std::pop_heap(report.errors.begin(), report.errors.end(), byLine);
+            report.errors.pop_back();
+        }
+        report.errors.push_back({line, std::move(message)});
+        std::push_heap(report.errors.begin(), report.errors.end(), byLine);
+    }
+};
+
+void ControlPointProcessor::loadBinary(const std::string& path) {
+    MappedFile file(path);
+    const char* p = file.data();
+    const char* end = p + file.size();
+    auto take = [&](void* out, size_t bytes) {
+        if (static_cast<size_t>(end - p) < bytes) {
+            throw std::runtime_error("Truncated file " + path);
+        }
+        std::memcpy(out, p, bytes);
+        p += bytes;
+    };
+
+    std::uint64_t header[3];
+    take(header, sizeof(header));
+    if (header[0] != BINARY_MAGIC) {
+        throw std::runtime_error("Not a control point file " + path);
+    }
+    std::uint64_t count = header[1];
+    std::uint64_t nameCount = header[2];
+    if (count > file.size() || nameCount > file.size()) {
+        throw std::runtime_error("Corrupted file " + path);
+    }
+
+    NameTable loadedNames;
+    for (std::uint64_t id = 0; id < nameCount; ++id) {
+        std::uint32_t length;
+        take(&length, sizeof(length));
+        if (static_cast<size_t>(end - p) < length) {
+            throw std::runtime_error("Truncated file " + path);
+        }
+        loadedNames.intern(std::string_view(p, length));
+        p += length;
+    }
+    if (loadedNames.size() != nameCount) {
+        throw std::runtime_error("Duplicate names in " + path);
+    }
+
+    auto readColumn = [&](auto& column, size_t n) {
+        column.resize(n);
+        take(column.data(), n * sizeof(column[0]));
+    };
+    std::vector<double> lats, lons, pens;
+    std::vector<std::uint32_t> ids;
+    std::vector<std::uint64_t> bits;
+    readColumn(lats, count);
+    readColumn(lons, count);
+    readColumn(pens, count);
+    readColumn(ids, count);
+    readColumn(bits, (count + 63) / 64);
+    for (std::uint32_t id : ids) {
+        if (id >= nameCount) {
+            throw std::runtime_error("Corrupted file " + path);
+        }
+    }
+    for (double penalty : pens) {
+        if (!(penalty >= 0.0 && penalty <= std::numeric_limits<double>::max())) {
+            throw std::runtime_error("Corrupted file " + path);
+        }
+    }
+
+    latitudes = std::move(lats);
+    longitudes = std::move(lons);
+    penalties = std::move(pens);
+    nameIds = std::move(ids);
+    mandatoryBits = std::move(bits);
+    names = std::move(loadedNames);
+}
+
+// Расстояния на сфере. Пункт переводится в единичный вектор (x, y, z); для
+// двух точек хорда c = |p - q| связана с формулой гаверсинусов соотношением
+// hav = c^2 / 4, поэтому d = 2R * asin(c / 2). Квадрат хорды считается
+// только умножениями и сложениями и хорошо векторизуется
+constexpr double EARTH_RADIUS_KM = 6371.0088;
+constexpr double DEG_TO_RAD = 3.14159265358979323846 / 180.0;
+
+struct UnitVector {
+    double x, y, z;
+};
+
+UnitVector toUnitVector(double lat, double lon) {
+    double phi = lat * DEG_TO_RAD;
+    double lambda = lon * DEG_TO_RAD;
+    return {std::cos(phi) * std::cos(lambda), std::cos(phi) * std::sin(lambda), std::sin(phi)};
+}
+
+double chordToKm(double chordSquared) {
+    return 2.0 * EARTH_RADIUS_KM * std::asin(std::min(1.0, std::sqrt(chordSquared) * 0.5));
+}
+
+double haversineKm(double lat1, double lon1, double lat2, double lon2) {
+    double dPhi = (lat2 - lat1) * DEG_TO_RAD;
+    double dLambda = (lon2 - lon1) * DEG_TO_RAD;
+    double s1 = std::sin(dPhi * 0.5);
+    double s2 = std::sin(dLambda * 0.5);
+    double a = s1 * s1 + std::cos(lat1 * DEG_TO_RAD) * std::cos(lat2 * DEG_TO_RAD) * s2 * s2;
+    return 2.0 * EARTH_RADIUS_KM * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+// Квадраты хорд от точки q до n точек, заданных колонками координат
+void chordSquaredBatch(const UnitVector& q, const double* xs, const double* ys, const double* zs,
+                       size_t n, double* out) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256d qx = _mm256_set1_pd(q.x);
+    const __m256d qy = _mm256_set1_pd(q.y);
+    const __m256d qz = _mm256_set1_pd(q.z);
+    for (; i + 4 <= n; i += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + i), qx);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + i), qy);
+        __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(zs + i), qz);
+        __m256d d2 = _mm256_mul_pd(dx, dx);
+#if defined(__FMA__)
+        d2 = _mm256_fmadd_pd(dy, dy, d2);
+        d2 = _mm256_fmadd_pd(dz, dz, d2);
+#else
+        // FMA - отдельное расширение: с одним -mavx2 его нет
+        d2 = _mm256_add_pd(d2, _mm256_mul_pd(dy, dy));
+        d2 = _mm256_add_pd(d2, _mm256_mul_pd(dz, dz));
+#endif
+        _mm256_storeu_pd(out + i, d2);
+    }
+#endif
+    for (; i < n; ++i) {
+        double dx = xs[i] - q.x;
+        double dy = ys[i] - q.y;
+        double dz = zs[i] - q.z;
+        out[i] = dx * dx + dy * dy + dz * dz;
+    }
+}
+
+// Пространственный индекс пунктов процессора: неявное k-d дерево по единичным
+// векторам (корректно у полюсов и на линии перемены дат). Узел - медиана
+// диапазона [begin, end), листья до LEAF_SIZE пунктов просматриваются пакетно
+class ControlPointIndex {
+public:
+    struct Nearest {
+        size_t index;       // номер пункта в процессоре
+        double distanceKm;
+    };
+
+    explicit ControlPointIndex(const ControlPointSpan& points) : order(points.size()) {
+        size_t n = points.size();
+        std::vector<UnitVector> vectors(n);
+        for (size_t i = 0; i < n; ++i) {
+            vectors[i] = toUnitVector(points.latitudes[i], points.longitudes[i]);
+            order[i] = i;
+        }
+        splitAxis.resize(n);
+        build(vectors, 0, n);
+
+        xs.resize(n);
+        ys.resize(n);
+        zs.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            const UnitVector& v = vectors[order[i]];
+            xs[i] = v.x;
+            ys[i] = v.y;
+            zs[i] = v.z;
+        }
+    }
+
+    size_t size() const { return order.size(); }
+
+    Nearest nearest(double lat, double lon) const {
+        if (order.empty()) {
+            throw std::logic_error("Index is empty");
+        }
+        UnitVector q = toUnitVector(lat, lon);
+        Best best;
+        search(q, 0, order.size(), best);
+        return {order[best.position], chordToKm(best.chordSquared)};
+    }
+
+    // Ближайшие пункты для пакета GPS-отметок, отметки делятся между потоками пула
+    void nearest(std::span<const double> lats, std::span<const double> lons,
+                 std::span<Nearest> out, ThreadPool& pool) const {
+        const size_t BATCH = 1024;
+        size_t batches = (lats.size() + BATCH - 1) / BATCH;
+        pool.parallelFor(batches, [&](size_t b) {
+            size_t end = std::min(lats.size(), (b + 1) * BATCH);
+            for (size_t i = b * BATCH; i < end; ++i) {
+                out[i] = nearest(lats[i], lons[i]);
+            }
+        });
+    }
+
+    // Расстояния от точки до всех пунктов (в порядке процессора), км
+    void distancesKm(double lat, double lon, std::span<double> out) const {
+        std::vector<double> chords(order.size());
+        chordSquaredBatch(toUnitVector(lat, lon), xs.data(), ys.data(), zs.data(), order.size(), chords.data());
+        for (size_t i = 0; i < order.size(); ++i) {
+            out[order[i]] = chordToKm(chords[i]);
+        }
+    }
+
+private:
+    static constexpr size_t LEAF_SIZE = 16;
+
+    struct Best {
+        size_t position = 0;
+        double chordSquared = std::numeric_limits<double>::infinity();
+    };
+
+    static double axisValue(const UnitVector& v, std::uint8_t axis) {
+        return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+    }
+
+    double coordinate(size_t position, std::uint8_t axis) const {
+        return axis == 0 ? xs[position] : axis == 1 ? ys[position] : zs[position];
+    }
+
+    // Деление по оси с наибольшим разбросом
+    void build(const std::vector<UnitVector>& vectors, size_t begin, size_t end) {
+        if (end - begin <= LEAF_SIZE) return;
+        double lo[3] = {2, 2, 2};
+        double hi[3] = {-2, -2, -2};
+        for (size_t i = begin; i < end; ++i) {
+            for (std::uint8_t axis = 0; axis < 3; ++axis) {
+                double value = axisValue(vectors[order[i]], axis);
+                lo[axis] = std::min(lo[axis], value);
+                hi[axis] = std::max(hi[axis], value);
+            }
+        }
+        std::uint8_t axis = 0;
+        for (std::uint8_t a = 1; a < 3; ++a) {
+            if (hi[a] - lo[a] > hi[axis] - lo[axis]) axis = a;
+        }
+
+        size_t mid = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                         [&](size_t a, size_t b) {
+                             return axisValue(vectors[a], axis) < axisValue(vectors[b], axis);
+                         });
+        splitAxis[mid] = axis;
+        build(vectors, begin, mid);
+        build(vectors, mid + 1, end);
+    }
+
+    void search(const UnitVector& q, size_t begin, size_t end, Best& best) const {
+        if (end - begin <= LEAF_SIZE) {
+            double chords[LEAF_SIZE];
+            size_t n = end - begin;
+            chordSquaredBatch(q, xs.data() + begin, ys.data() + begin, zs.data() + begin, n, chords);
+            for (size_t i = 0; i < n; ++i) {
+                if (chords[i] < best.chordSquared) {
+                    best.chordSquared = chords[i];
+                    best.position = begin + i;
+                }
+            }
+            return;
+        }
+
+        size_t mid = begin + (end - begin) / 2;
+        std::uint8_t axis = splitAxis[mid];
+        double dx = xs[mid] - q.x;
+        double dy = ys[mid] - q.y;
+        double dz = zs[mid] - q.z;
+        double chord = dx * dx + dy * dy + dz * dz;
+        if (chord < best.chordSquared) {
+            best.chordSquared = chord;
+            best.position = mid;
+        }
+
+        double diff = axisValue(q, axis) - coordinate(mid, axis);
+        if (diff < 0) {
+            search(q, begin, mid, best);
+            if (diff * diff < best.chordSquared) search(q, mid + 1, end, best);
+        } else {
+            search(q, mid + 1, end, best);
+            if (diff * diff < best.chordSquared) search(q, begin, mid, best);
+        }
+    }
+
+    std::vector<size_t> order;              // позиция в дереве -> номер пункта
+    std::vector<std::uint8_t> splitAxis;    // ось деления узла-медианы
+    std::vector<double> xs, ys, zs;         // координаты в порядке дерева
+};
+
+// Длина маршрута через все пункты по порядку, км
+double routeLengthKm(const ControlPointSpan& points) {
+    double total = 0.0;
+    if (points.size() < 2) return total;
+    UnitVector prev = toUnitVector(points.latitudes[0], points.longitudes[0]);
+    for (size_t i = 1; i < points.size(); ++i) {
+        UnitVector cur = toUnitVector(points.latitudes[i], points.longitudes[i]);
+        double dx = cur.x - prev.x;
+        double dy = cur.y - prev.y;
+        double dz = cur.z - prev.z;
+        total += chordToKm(dx * dx + dy * dy + dz * dz);
+        prev = cur;
+    }
+    return total;
+}
+
+// Подсчёт штрафов участников в реальном времени. Для каждого участника
+// хранится битовый набор взятых пунктов и текущий результат, которые
+// обновляются атомарно при каждой отметке, без блокировок и без пересчёта.
+// Результат упакован в одно 64-битное число: старшие биты - число не взятых
+// обязательных пунктов, младшие 40 бит - штраф в тысячных долях часа. Меньшее
+// число означает лучшее место, а взятие пункта - это один fetch_sub
+class LiveScoring {
+public:
+    struct Standing {
+        size_t participant;
+        size_t missedMandatory;
+        double penalty;
+    };
+
+    LiveScoring(const ControlPointSpan& points, size_t participants)
+        : pointCount(points.size()),
+          wordsPerParticipant((points.size() + 63) / 64),
+          participantCount(participants),
+          costs(points.size()),
+          visits(new std::atomic<std::uint64_t>[participants * ((points.size() + 63) / 64)]),
+          scores(new std::atomic<std::uint64_t>[participants]) {
+        std::uint64_t mandatoryCount = 0;
+        std::uint64_t optionalUnits = 0;
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (points.isMandatory(i)) {
+                costs[i] = MANDATORY_UNIT;
+                ++mandatoryCount;
+            } else {
+                costs[i] = static_cast<std::uint64_t>(std::llround(points.penalties[i] * PENALTY_SCALE));
+                optionalUnits += costs[i];
+            }
+        }
+        if (mandatoryCount >= (std::uint64_t{1} << (64 - PENALTY_BITS)) || optionalUnits >= MANDATORY_UNIT) {
+            throw std::invalid_argument("Too many control points for live scoring");
+        }
+        std::uint64_t initial = mandatoryCount * MANDATORY_UNIT + optionalUnits;
+        for (size_t w = 0; w < participants * wordsPerParticipant; ++w) {
+            visits[w].store(0, std::memory_order_relaxed);
+        }
+        for (size_t p = 0; p < participants; ++p) {
+            scores[p].store(initial, std::memory_order_relaxed);
+        }
+    }
+
+    size_t participants() const { return participantCount; }
+
+    // Отметка участника на пункте. Повторная отметка ничего не меняет.
+    // Возвращает true, если пункт взят впервые
+    bool recordVisit(size_t participant, size_t point) {
+        checkIndex(participant, point);
+        std::uint64_t bit = std::uint64_t{1} << (point % 64);
+        std::atomic<std::uint64_t>& word = visits[participant * wordsPerParticipant + point / 64];
+        if (word.fetch_or(bit, std::memory_order_relaxed) & bit) {
+            return false;
+        }
+        scores[participant].fetch_sub(costs[point], std::memory_order_relaxed);
+        return true;
+    }
+
+    bool visited(size_t participant, size_t point) const {
+        checkIndex(participant, point);
+        std::uint64_t word = visits[participant * wordsPerParticipant + point / 64].load(std::memory_order_relaxed);
+        return (word >> (point % 64)) & 1;
+    }
+
+    Standing standing(size_t participant) const {
+        return unpack(participant, scores[participant].load(std::memory_order_relaxed));
+    }
+
+    // Первые top участников: частичная сортировка текущих результатов
+    std::vector<Standing> leaderboard(size_t top) const {
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> current(participantCount);
+        for (size_t p = 0; p < participantCount; ++p) {
+            current[p] = {scores[p].load(std::memory_order_relaxed), static_cast<std::uint32_t>(p)};
+        }
+        top = std::min(top, current.size());
+        std::partial_sort(current.begin(), current.begin() + top, current.end());
+
+        std::vector<Standing> result;
+        result.reserve(top);
+        for (size_t i = 0; i < top; ++i) {
+            result.push_back(unpack(current[i].second, current[i].first));
+        }
+        return result;
+    }
+
+    // Штраф участника, пересчитанный заново по битовому набору (для проверки)
+    Standing recompute(size_t participant) const {
+        std::uint64_t score = 0;
+        for (size_t i = 0; i < pointCount; ++i) {
+            if (!visited(participant, i)) score += costs[i];
+        }
+        return unpack(participant, score);
+    }
+
+private:
+    static constexpr unsigned PENALTY_BITS = 40;
+    static constexpr std::uint64_t MANDATORY_UNIT = std::uint64_t{1} << PENALTY_BITS;
+    static constexpr double PENALTY_SCALE = 1000.0;
+
+    void checkIndex(size_t participant, size_t point) const {
+        if (participant >= participantCount || point >= pointCount) {
+            throw std::out_of_range("Unknown participant or control point");
+        }
+    }
+
+    static Standing unpack(size_t participant, std::uint64_t score) {
+        return {participant, static_cast<size_t>(score >> PENALTY_BITS),
+                static_cast<double>(score & (MANDATORY_UNIT - 1)) / PENALTY_SCALE};
+    }
+
+    size_t pointCount;
+    size_t wordsPerParticipant;
+    size_t participantCount;
+    std::vector<std::uint64_t> costs;                        // цена невзятого пункта
+    std::unique_ptr<std::atomic<std::uint64_t>[]> visits;    // биты взятых пунктов
+    std::unique_ptr<std::atomic<std::uint64_t>[]> scores;    // упакованный результат
+};
+
+// Бенчмарк статистики штрафов на синтетических пунктах: построчный путь
+// через объекты ControlPoint (как до колоночного хранения), обход по видам
+// из TypeList, построчный путь по колонкам и пакетный PenaltyStatisticsBuilder
+void runBenchmark(size_t count) {
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> penaltyDist(0.0, 5.0);
+
+    std::vector<std::unique_ptr<ControlPoint>> objects;
+    objects.reserve(count);
+    StaticControlPointProcessor<ControlPointKinds> byKind;
+    ControlPointProcessor processor;
+    processor.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string name = "КП " + std::to_string(i % 1000);
+        double lat = 55.0 + (i % 1000) * 1e-4;
+        double lon = 37.0 + (i % 1000) * 1e-4;
+        if (rng() % 3 == 0) {
+            objects.push_back(std::make_unique<MandatoryControlPoint>(name, lat, lon));
+            byKind.addControlPoint<MandatoryControlPoint>(name, lat, lon);
+        } else {
+            objects.push_back(std::make_unique<OptionalControlPoint>(name, lat, lon, penaltyDist(rng)));
+            byKind.addControlPoint<OptionalControlPoint>(name, lat, lon, objects.back()->getPenalty());
+        }
+        processor.addControlPoint(name, lat, lon, objects.back()->getPenalty(), objects.back()->isMandatory());
+    }
+
+    auto measure = [count](const char* name, auto&& run) {
+        auto begin = std::chrono::steady_clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << std::setw(28) << std::left << name << std::right << std::fixed << std::setprecision(1)
+                  << seconds * 1000 << " ms, " << count / seconds / 1e6 << " M points/s\n";
+    };
+
+    std::cout << "Points: " << count << "\n";
+    PenaltyStatisticsBuilder perObject;
+    measure("virtual ControlPoint", [&] {
+        for (const auto& cp : objects) {
+            perObject.addControlPoint({cp->getName(), cp->getLatitude(), cp->getLongitude(),
+                                       cp->getPenalty(), cp->isMandatory()});
+        }
+    });
+
+    PenaltyStatisticsBuilder perKind;
+    measure("TypeList static dispatch", [&] { byKind.visit(perKind); });
+
+    PenaltyStatisticsBuilder perPoint;
+    measure("per-point statistics", [&] { perPoint.ControlPointBuilder::addControlPoints(processor.points()); });
+
+    PenaltyStatisticsBuilder batch;
+    measure("batch statistics", [&] { batch.addControlPoints(processor.points()); });
+
+    std::cout << std::setprecision(3) << "Skipped: " << perObject.getSkippedPoints() << " / "
+              << perKind.getSkippedPoints() << " / " << perPoint.getSkippedPoints() << " / "
+              << batch.getSkippedPoints() << "\n";
+    std::cout << "Total: " << perObject.getTotalPenalty() << " / " << perKind.getTotalPenalty() << " / "
+              << perPoint.getTotalPenalty() << " / " << batch.getTotalPenalty() << "\n";
+    // Пакетный путь суммирует в другом порядке - сумма сравнивается с допуском
+    bool batchMatches = perPoint.getHistogram() == batch.getHistogram() &&
+                        perPoint.getMinPenalty() == batch.getMinPenalty() &&
+                        perPoint.getMaxPenalty() == batch.getMaxPenalty() &&
+                        std::abs(perPoint.getTotalPenalty() - batch.getTotalPenalty()) <=
+                            1e-9 * std::abs(perPoint.getTotalPenalty());
+    std::cout << "Min/max: " << batch.getMinPenalty() << " / " << batch.getMaxPenalty()
+              << ", batch vs per-point min/max/sum/histogram " << (batchMatches ? "match" : "DIFFER") << "\n";
+}
+
+// Бенчмарк processAll: статистика и подсчёт штрафов одним проходом на разном
+// числе потоков против двух последовательных вызовов process
+void runParallelBenchmark(size_t count) {
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> penaltyDist(0.0, 5.0);
+    ControlPointProcessor processor;
+    processor.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        bool mandatory = rng() % 3 == 0;
+        processor.addControlPoint("КП " + std::to_string(i % 1000), 55.0, 37.0,
+                                  mandatory ? 0.0 : penaltyDist(rng), mandatory);
+    }
+
+    // Вывод результатов строителей не нужен - подменяем буфер std::cout
+    std::streambuf* saved = std::cout.rdbuf(nullptr);
+    auto elapsed = [](auto&& run) {
+        auto begin = std::chrono::steady_clock::now();
+        run();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    };
+
+    std::vector<std::pair<std::string, double>> results;
+    results.emplace_back("serial process x2", elapsed([&] {
+        PenaltyCalculatorBuilder penalty;
+        PenaltyStatisticsBuilder statistics;
+        processor.process(penalty);
+        processor.process(statistics);
+    }));
+    size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool pool(threads);
+        results.emplace_back("processAll, " + std::to_string(threads) + " threads", elapsed([&] {
+            PenaltyCalculatorBuilder penalty;
+            PenaltyStatisticsBuilder statistics;
+            processor.processAll(pool, penalty, statistics);
+        }));
+    }
+    std::cout.rdbuf(saved);
+
+    std::cout << "Points: " << count << "\n";
+    for (const auto& [name, seconds] : results) {
+        std::cout << std::setw(28) << std::left << name << std::right << std::fixed << std::setprecision(1)
+                  << seconds * 1000 << " ms, " << count / seconds / 1e6 << " M points/s\n";
+    }
+}
+
+// Бенчмарк поиска ближайшего пункта: k-d дерево против полного перебора
+// пакетным ядром. Пункты - в квадрате 2x2 градуса, отметки - там же
+void runGeoBenchmark(size_t count, size_t queries) {
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> latDist(55.0, 57.0);
+    std::uniform_real_distribution<double> lonDist(37.0, 39.0);
+    ControlPointProcessor processor;
+    processor.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        processor.addControlPoint("КП " + std::to_string(i % 1000), latDist(rng), lonDist(rng), 0.0, true);
+    }
+    std::vector<double> lats(queries), lons(queries);
+    for (size_t i = 0; i < queries; ++i) {
+        lats[i] = latDist(rng);
+        lons[i] = lonDist(rng);
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    ControlPointIndex index(processor.points());
+    double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::vector<ControlPointIndex::Nearest> found(queries);
+    ThreadPool pool;
+    begin = std::chrono::steady_clock::now();
+    index.nearest(lats, lons, found, pool);
+    double treeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // Перебор дорогой - проверяем только часть отметок
+    size_t bruteQueries = std::min<size_t>(queries, 200);
+    std::vector<double> distances(count);
+    size_t mismatches = 0;
+    begin = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < bruteQueries; ++q) {
+        index.distancesKm(lats[q], lons[q], distances);
+        size_t best = static_cast<size_t>(std::min_element(distances.begin(), distances.end()) - distances.begin());
+        ControlPointView point = processor.points()[found[q].index];
+        double reference = haversineKm(lats[q], lons[q], point.getLatitude(), point.getLongitude());
+        if (std::abs(distances[best] - found[q].distanceKm) > 1e-9 ||
+            std::abs(reference - found[q].distanceKm) > 1e-6) {
+            ++mismatches;
+        }
+    }
+    double bruteSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Points: " << count << ", index built in " << buildSeconds * 1000 << " ms\n";
+    std::cout << "k-d tree:    " << queries / treeSeconds << " queries/s (" << pool.size() << " threads)\n";
+    std::cout << "brute force: " << bruteQueries / bruteSeconds << " queries/s, "
+              << count * bruteQueries / bruteSeconds / 1e6 << " M distances/s\n";
+    std::cout << "Mismatches: " << mismatches << " of " << bruteQueries << "\n";
+    std::cout << "Route length: " << routeLengthKm(processor.points()) << " km\n";
+}
+
+// Бенчмарк загрузки: генерируется CSV заданного размера (каждая 100000-я
+// строка с неверными координатами), затем загрузка CSV, сохранение и
+// повторная загрузка двоичного файла
+void runLoadBenchmark(size_t megabytes, const std::string& path) {
+    {
+        std::ofstream csv(path, std::ios::binary | std::ios::trunc);
+        csv << "name,latitude,longitude,penalty,mandatory\n";
+        std::mt19937_64 rng(1);
+        std::string line;
+        char number[32];
+        for (size_t i = 0; static_cast<size_t>(csv.tellp()) < megabytes * 1024 * 1024; ++i) {
+            line = "КП " + std::to_string(i % 5000) + ",";
+            double lat = i % 100000 == 99999 ? 123.0 : 55.0 + (rng() % 2000000) * 1e-6;
+            line.append(number, std::to_chars(number, number + sizeof(number), lat).ptr) += ',';
+            double lon = 37.0 + (rng() % 2000000) * 1e-6;
+            line.append(number, std::to_chars(number, number + sizeof(number), lon).ptr) += ',';
+            if (i % 3 == 0) {
+                line += ",1\n";
+            } else {
+                line += std::to_string(rng() % 10) + ".5,0\n";
+            }
+            csv << line;
+        }
+    }
+
+    auto elapsed = [](auto&& run) {
+        auto begin = std::chrono::steady_clock::now();
+        run();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    };
+
+    ControlPointProcessor csvProcessor;
+    ControlPointLoader::LoadReport report;
+    double csvSeconds = elapsed([&] { report = ControlPointLoader::loadCsv(path, csvProcessor); });
+    std::string binaryPath = path + ".bin";
+    double saveSeconds = elapsed([&] { csvProcessor.saveBinary(binaryPath); });
+    ControlPointProcessor binaryProcessor;
+    double binarySeconds = elapsed([&] { binaryProcessor.loadBinary(binaryPath); });
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "CSV: " << megabytes << " MiB, " << report.loaded << " points, " << report.rejected
+              << " rejected (first: line " << (report.errors.empty() ? 0 : report.errors[0].line) << ", "
+              << (report.errors.empty() ? "-" : report.errors[0].message) << ")\n";
+    std::cout << "CSV load:    " << csvSeconds << " s, " << report.loaded / csvSeconds / 1e6 << " M points/s, "
+              << megabytes / csvSeconds << " MiB/s\n";
+    std::cout << "binary save: " << saveSeconds << " s\n";
+    std::cout << "binary load: " << binarySeconds << " s, " << binaryProcessor.size() / binarySeconds / 1e6
+              << " M points/s\n";
+    std::remove(binaryPath.c_str());
+    std::remove(path.c_str());
+}
+
+// Поток, который только считает записанные байты
+class CountingBuf : public std::streambuf {
+public:
+    size_t bytes = 0;
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) ++bytes;
+        return ch;
+    }
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        bytes += static_cast<size_t>(n);
+        return n;
+    }
+};
+
+// Бенчмарк текстового отчёта: форматирование через iostream-манипуляторы
+// (прежний способ) против TextListBuilder в поток и в файл через mmap
+void runReportBenchmark(size_t count, const std::string& path) {
+    std::mt19937_64 rng(3);
+    std::uniform_real_distribution<double> latDist(55.0, 57.0);
+    std::uniform_real_distribution<double> lonDist(37.0, 39.0);
+    ControlPointProcessor processor;
+    processor.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        bool mandatory = rng() % 3 == 0;
+        processor.addControlPoint("КП " + std::to_string(i % 1000), latDist(rng), lonDist(rng),
+                                  mandatory ? 0.0 : (rng() % 50) / 10.0, mandatory);
+    }
+
+    auto report = [count](const char* name, size_t bytes, double seconds) {
+        std::cout << std::setw(22) << std::left << name << std::right << std::fixed << std::setprecision(1)
+                  << seconds * 1000 << " ms, " << count / seconds / 1e6 << " M rows/s, "
+                  << bytes / seconds / (1024 * 1024) << " MiB/s\n";
+    };
+    auto elapsed = [](auto&& run) {
+        auto begin = std::chrono::steady_clock::now();
+        run();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    };
+
+    CountingBuf legacyBuf;
+    std::ostream legacy(&legacyBuf);
+    double legacySeconds = elapsed([&] {
+        ControlPointSpan points = processor.points();
+        for (size_t i = 0; i < points.size(); ++i) {
+            ControlPointView cp = points[i];
+            legacy << std::setw(2) << std::right << i + 1 << " | ";
+            legacy << std::setw(17) << std::left << cp.getName() << " | ";
+            legacy << "(" << std::fixed << std::setprecision(6) << cp.getLatitude() << ", "
+                   << cp.getLongitude() << ") | ";
+            if (cp.isMandatory()) {
+                legacy << "незачёт СУ";
+            } else {
+                legacy << std::setprecision(1) << cp.getPenalty() << " ч";
+            }
+            legacy << "\n";
+        }
+    });
+    report("iostream", legacyBuf.bytes, legacySeconds);
+
+    CountingBuf streamBuf;
+    std::ostream stream(&streamBuf);
+    double streamSeconds = elapsed([&] {
+        TextListBuilder builder(stream);
+        processor.process(builder);
+    });
+    report("TextListBuilder", streamBuf.bytes, streamSeconds);
+
+    TextListBuilder fileBuilder;
+    double fileSeconds = elapsed([&] {
+        fileBuilder.addControlPoints(processor.points());
+        fileBuilder.writeToFile(path);
+    });
+    report("TextListBuilder mmap", streamBuf.bytes, fileSeconds);
+    std::remove(path.c_str());
+}
+
+// Бенчмарк live-подсчёта: поток случайных отметок от участников,
+// распределённый по пулу потоков, и запросы таблицы лидеров
+void runLiveBenchmark(size_t participants, size_t pointCount, size_t visitCount) {
+    std::mt19937_64 rng(11);
+    ControlPointProcessor processor;
+    processor.reserve(pointCount);
+    for (size_t i = 0; i < pointCount; ++i) {
+        bool mandatory = i % 4 == 0;
+        processor.addControlPoint("КП " + std::to_string(i), 55.0, 37.0,
+                                  mandatory ? 0.0 : (rng() % 10) / 2.0, mandatory);
+    }
+    LiveScoring scoring(processor.points(), participants);
+
+    ThreadPool pool;
+    const size_t BATCH = 1 << 16;
+    size_t batches = (visitCount + BATCH - 1) / BATCH;
+    auto begin = std::chrono::steady_clock::now();
+    pool.parallelFor(batches, [&](size_t b) {
+        std::mt19937_64 local(b);
+        size_t end = std::min(visitCount, (b + 1) * BATCH);
+        for (size_t i = b * BATCH; i < end; ++i) {
+            scoring.recordVisit(local() % participants, local() % pointCount);
+        }
+    });
+    double visitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    const size_t QUERIES = 100;
+    std::vector<LiveScoring::Standing> top;
+    begin = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < QUERIES; ++q) {
+        top = scoring.leaderboard(10);
+    }
+    double querySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    size_t mismatches = 0;
+    for (size_t p = 0; p < std::min<size_t>(participants, 1000); ++p) {
+        LiveScoring::Standing live = scoring.standing(p);
+        LiveScoring::Standing full = scoring.recompute(p);
+        if (live.missedMandatory != full.missedMandatory || live.penalty != full.penalty) ++mismatches;
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Participants: " << participants << ", control points: " << pointCount << "\n";
+    std::cout << "Visits: " << visitCount << " in " << visitSeconds * 1000 << " ms, "
+              << visitCount / visitSeconds / 1e6 << " M visits/s (" << pool.size() << " threads)\n";
+    std::cout << "Leaderboard top-10: " << querySeconds / QUERIES * 1000 << " ms per query\n";
+    std::cout << "Leader: participant " << top[0].participant << ", missed mandatory "
+              << top[0].missedMandatory << ", penalty " << top[0].penalty << " h\n";
+    std::cout << "Mismatches against full recompute: " << mismatches << "\n";
+}
+
+// Запуск: program - демонстрация, program --bench [points] - бенчмарк статистики,
+// program --bench-parallel [points] - бенчмарк processAll,
+// program --bench-geo [points] [queries] - бенчмарк поиска ближайшего пункта,
+// program --bench-load [MiB] [file] - бенчмарк загрузки CSV и двоичного формата,
+// program --bench-report [points] [file] - бенчмарк текстового отчёта,
+// program --bench-live [participants] [points] [visits] - бенчмарк live-подсчёта,
+// program --load {file.csv|file.bin} - загрузить пункты из файла и вывести статистику
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && std::strcmp(argv[1], "--bench") == 0) {
+        runBenchmark(argc >= 3 ? std::stoul(argv[2]) : 10000000);
+        return 0;
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-parallel") == 0) {
+        runParallelBenchmark(argc >= 3 ? std::stoul(argv[2]) : 10000000);
+        return 0;
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-report") == 0) {
+        runReportBenchmark(argc >= 3 ? std::stoul(argv[2]) : 5000000,
+                           argc >= 4 ? argv[3] : "control_points_report.txt");
+        return 0;
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-live") == 0) {
+        runLiveBenchmark(argc >= 3 ? std::stoul(argv[2]) : 100000,
+                         argc >= 4 ? std::stoul(argv[3]) : 1000,
+                         argc >= 5 ? std::stoul(argv[4]) : 50000000);
+        return 0;
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-load") == 0) {
+        runLoadBenchmark(argc >= 3 ? std::stoul(argv[2]) : 1024,
+                         argc >= 4 ? argv[3] : "control_points_bench.csv");
+        return 0;
+    }
+    if (argc >= 3 && std::strcmp(argv[1], "--load") == 0) {
+        try {
+            ControlPointProcessor processor;
+            std::string path = argv[2];
+            if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".bin") == 0) {
+                processor.loadBinary(path);
+            } else {
+                auto report = ControlPointLoader::loadCsv(path, processor);
+                std::cout << "Загружено КП: " << report.loaded << ", отклонено: " << report.rejected << "\n";
+                for (const auto& error : report.errors) {
+                    std::cout << "  строка " << error.line << ": " << error.message << "\n";
+                }
+            }
+            PenaltyStatisticsBuilder statistics;
+            processor.process(statistics);
+        } catch (const std::exception& e) {
+            std::cerr << "Ошибка: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-geo") == 0) {
+        runGeoBenchmark(argc >= 3 ? std::stoul(argv[2]) : 1000000,
+                        argc >= 4 ? std::stoul(argv[3]) : 1000000);
+        return 0;
+    }
+
     try {
         ControlPointProcessor processor;
         
@@ -171,6 +1959,44 @@ int main() {
         
         PenaltyCalculatorBuilder penaltyBuilder;
         processor.process(penaltyBuilder);
+
+        PenaltyStatisticsBuilder statisticsBuilder;
+        processor.process(statisticsBuilder);
+
+        // Те же строители одним проходом на пуле потоков
+        ThreadPool pool;
+        TextListBuilder parallelText;
+        PenaltyStatisticsBuilder parallelStatistics;
+        processor.processAll(pool, parallelText, parallelStatistics);
+
+        // Закрытый набор видов: пункты по видам, строители без виртуальных вызовов
+        StaticControlPointProcessor<ControlPointKinds> byKind;
+        byKind.addControlPoint<MandatoryControlPoint>("Старт", 55.752222, 37.615555);
+        byKind.addControlPoint<OptionalControlPoint>("Горный перевал", 55.755800, 37.617600, 2.5);
+        byKind.addControlPoint<MandatoryControlPoint>("Речная переправа", 55.758600, 37.622100);
+        byKind.addControlPoint<OptionalControlPoint>("Лесной участок", 55.761200, 37.626500, 1.5);
+        byKind.addControlPoint<MandatoryControlPoint>("Финиш", 55.763900, 37.630500);
+        PenaltyCalculatorBuilder staticPenalty;
+        byKind.process(staticPenalty);
+
+        // Длина маршрута и ближайший к GPS-отметке пункт
+        ControlPointIndex index(processor.points());
+        auto nearest = index.nearest(55.7590, 37.6230);
+        std::cout << "\nДлина маршрута: " << std::setprecision(3) << routeLengthKm(processor.points()) << " км\n";
+        std::cout << "Ближайший к (55.759000, 37.623000) КП: " << processor.points()[nearest.index].getName()
+                  << ", " << nearest.distanceKm << " км\n";
+
+        // Подсчёт в реальном времени: участники отмечаются на пунктах по мере прохождения
+        LiveScoring scoring(processor.points(), 3);
+        for (size_t point : {0, 1, 2, 3, 4}) scoring.recordVisit(0, point);
+        for (size_t point : {0, 2, 4}) scoring.recordVisit(1, point);
+        for (size_t point : {0, 1, 3}) scoring.recordVisit(2, point);
+        std::cout << "\nТаблица лидеров:\n";
+        for (const auto& standing : scoring.leaderboard(3)) {
+            std::cout << "  участник " << standing.participant + 1
+                      << ": не взято обязательных КП " << standing.missedMandatory
+                      << ", штраф " << std::setprecision(1) << standing.penalty << " ч\n";
+        }
         
     } catch (const std::exception& e) {
         std::cerr << "Ошибка: " << e.what() << std::endl;
@@ -0,0 +1,347 @@
+#pragma once
+
+// Необязательный слой измерений: таймеры участков кода с гистограммами
+// задержек, счётчики выделений памяти и именованные счётчики.
+//
+// Включается сборкой с -DINSTRUMENTATION. Без него макросы ниже
+// раскрываются в пустоту и ничего не стоят, а заголовок не тянет зависимостей.
+//
+//   INSTR_SCOPE("Log::message");      // время до конца блока
+//   INSTR_COUNT("Log::dropped", 1);   // именованный счётчик
+//   INSTR_REPORT("report.txt");       // отчёт сейчас
+//
+// При включённом слое глобальные operator new/delete заменяются счётчиками
+// по потокам, а при выходе из программы отчёт пишется в файл из переменной
+// окружения INSTRUMENTATION_REPORT (по умолчанию instrumentation_report.txt).
+// Каждая программа в репозитории - одна единица трансляции, поэтому
+// заголовок определяет всё сам и подключается один раз на программу.
+// Имена вида "Подсистема::точка" группируются в отчёте по подсистемам
+
+#ifdef INSTRUMENTATION
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+
+namespace instr {
+
+// Гистограмма в духе HDR: значения до 32 хранятся точно, дальше на каждую
+// степень двойки по 32 корзины - относительная ошибка не больше 1/32.
+// Запись - один relaxed fetch_add, поэтому писать можно из любых потоков
+class Histogram {
+public:
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr std::uint64_t SUB = std::uint64_t{1} << SUB_BITS;
+    static constexpr size_t BUCKETS = SUB * (64 - SUB_BITS);
+
+    void record(std::uint64_t value) {
+        buckets[indexOf(value)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(value, std::memory_order_relaxed);
+        std::uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (value > seen && !maximum.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::uint64_t samples() const { return count.load(std::memory_order_relaxed); }
+    std::uint64_t sum() const { return total.load(std::memory_order_relaxed); }
+    std::uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+
+    // Верхняя граница корзины, в которую попал q-квантиль
+    std::uint64_t percentile(double q) const {
+        std::uint64_t n = samples();
+        if (n == 0) return 0;
+        std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(n - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) return std::min(upperBound(i), max());
+        }
+        return max();
+    }
+
+    static size_t indexOf(std::uint64_t value) {
+        if (value < SUB) return static_cast<size_t>(value);
+        unsigned shift = static_cast<unsigned>(std::bit_width(value)) - SUB_BITS - 1;
+        return static_cast<size_t>(SUB * (shift + 1) + ((value >> shift) - SUB));
+    }
+
+    static std::uint64_t upperBound(size_t index) {
+        if (index < SUB) return index;
+        unsigned shift = static_cast<unsigned>(index / SUB - 1);
+        std::uint64_t mantissa = index % SUB + SUB;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, BUCKETS> buckets{};
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::uint64_t> total{0};
+    std::atomic<std::uint64_t> maximum{0};
+};
+
+class Counter {
+public:
+    void add(std::int64_t delta) { value.fetch_add(delta, std::memory_order_relaxed); }
+    std::int64_t get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::int64_t> value{0};
+};
+
+// Счётчики выделений одного потока. Пишет только владелец (relaxed
+// store без lock-префикса), отчёт читает. Ячейки берутся из статического
+// массива: регистрация потока не должна сама выделять память
+struct AllocationTally {
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> deallocations{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<bool> used{false};
+
+    static void bump(std::atomic<std::uint64_t>& value, std::uint64_t delta) {
+        value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+};
+
+class AllocationStats {
+public:
+    static constexpr size_t MAX_THREADS = 256;
+
+    struct Totals {
+        std::uint64_t allocations = 0;
+        std::uint64_t deallocations = 0;
+        std::uint64_t bytes = 0;
+        size_t threads = 0;
+    };
+
+    static AllocationStats& instance() {
+        static AllocationStats stats;  // без динамической памяти внутри
+        return stats;
+    }
+
+    void onAllocate(std::size_t size) {
+        if (AllocationTally* tally = local()) {
+            AllocationTally::bump(tally->allocations, 1);
+            AllocationTally::bump(tally->bytes, size);
+        } else {
+            overflow.allocations.fetch_add(1, std::memory_order_relaxed);
+            overflow.bytes.fetch_add(size, std::memory_order_relaxed);
+        }
+    }
+
+    void onDeallocate() {
+        if (AllocationTally* tally = local()) {
+            AllocationTally::bump(tally->deallocations, 1);
+        } else {
+            overflow.deallocations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    Totals totals() const {
+        Totals result;
+        auto add = [&](const AllocationTally& tally) {
+            result.allocations += tally.allocations.load(std::memory_order_relaxed);
+            result.deallocations += tally.deallocations.load(std::memory_order_relaxed);
+            result.bytes += tally.bytes.load(std::memory_order_relaxed);
+        };
+        size_t claimed = std::min(next.load(std::memory_order_acquire), MAX_THREADS);
+        for (size_t i = 0; i < claimed; ++i) {
+            if (tallies[i].used.load(std::memory_order_acquire)) {
+                add(tallies[i]);
+                ++result.threads;
+            }
+        }
+        add(overflow);
+        return result;
+    }
+
+private:
+    // Ячейка потока; сверх MAX_THREADS потоки считаются в общей ячейке атомарно
+    AllocationTally* local() {
+        thread_local AllocationTally* mine = claim();
+        return mine;
+    }
+
+    AllocationTally* claim() {
+        size_t index = next.fetch_add(1, std::memory_order_relaxed);
+        if (index >= MAX_THREADS) return nullptr;
+        tallies[index].used.store(true, std::memory_order_release);
+        return &tallies[index];
+    }
+
+    std::array<AllocationTally, MAX_THREADS> tallies{};
+    AllocationTally overflow;
+    std::atomic<size_t> next{0};
+};
+
+// Именованные гистограммы и счётчики. Адреса стабильны (std::map), поэтому
+// макросы находят их один раз и кэшируют ссылку в статической переменной
+class Registry {
+public:
+    static Registry& instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    Histogram& histogram(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& slot = histograms[name];
+        if (!slot) slot = std::make_unique<Histogram>();
+        return *slot;
+    }
+
+    Counter& counter(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return counters[name];
+    }
+
+    void report(std::ostream& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        AllocationStats::Totals allocations = AllocationStats::instance().totals();
+        out << "=== Instrumentation report ===\n";
+        out << "allocations: " << allocations.allocations << " (" << allocations.bytes << " bytes), "
+            << "deallocations: " << allocations.deallocations << ", live: "
+            << static_cast<std::int64_t>(allocations.allocations - allocations.deallocations)
+            << ", threads: " << allocations.threads << "\n";
+
+        std::string subsystem;
+        auto header = [&](const std::string& name) {
+            std::string prefix = name.substr(0, name.find("::"));
+            if (prefix != subsystem) {
+                subsystem = prefix;
+                out << "\n[" << subsystem << "]\n";
+            }
+        };
+        for (const auto& [name, histogram] : histograms) {
+            header(name);
+            std::uint64_t n = histogram->samples();
+            out << "  " << std::left << std::setw(36) << name << std::right << " calls " << n;
+            if (n != 0) {
+                out << std::fixed << std::setprecision(1) << ", mean " << static_cast<double>(histogram->sum()) / n
+                    << " ns, p50 " << histogram->percentile(0.50) << ", p90 " << histogram->percentile(0.90)
+                    << ", p99 " << histogram->percentile(0.99) << ", p99.9 " << histogram->percentile(0.999)
+                    << ", max " << histogram->max() << " ns";
+            }
+            out << "\n";
+        }
+        for (const auto& [name, counter] : counters) {
+            header(name);
+            out << "  " << std::left << std::setw(36) << name << std::right << " = " << counter.get() << "\n";
+        }
+    }
+
+    bool dump(const std::string& path) {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file) return false;
+        report(file);
+        return static_cast<bool>(file);
+    }
+
+private:
+    Registry() = default;
+
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+    std::map<std::string, Counter> counters;
+};
+
+// Время жизни объекта в наносекундах -> гистограмма
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram(histogram), begin(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - begin;
+        histogram.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& histogram;
+    std::chrono::steady_clock::time_point begin;
+};
+
+// Отчёт при завершении программы
+struct ExitReport {
+    ExitReport() {
+        AllocationStats::instance();
+        Registry::instance();  // создан раньше - разрушится позже нас
+    }
+
+    ~ExitReport() {
+        const char* path = std::getenv("INSTRUMENTATION_REPORT");
+        Registry::instance().dump(path ? path : "instrumentation_report.txt");
+    }
+};
+
+inline ExitReport exitReport;
+
+} // namespace instr
+
+void* operator new(std::size_t size) {
+    instr::AllocationStats::instance().onAllocate(size);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr == nullptr) return;
+    instr::AllocationStats::instance().onDeallocate();
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    ::operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+#define INSTR_CONCAT_IMPL(a, b) a##b
+#define INSTR_CONCAT(a, b) INSTR_CONCAT_IMPL(a, b)
+
+#define INSTR_SCOPE(name)                                                                        \
+    static ::instr::Histogram& INSTR_CONCAT(instrHistogram_, __LINE__) =                         \
+        ::instr::Registry::instance().histogram(name);                                           \
+    ::instr::ScopedTimer INSTR_CONCAT(instrTimer_, __LINE__)(INSTR_CONCAT(instrHistogram_, __LINE__))
+
+#define INSTR_COUNT(name, delta)                                                                 \
+    do {                                                                                         \
+        static ::instr::Counter& instrCounter = ::instr::Registry::instance().counter(name);     \
+        instrCounter.add(delta);                                                                 \
+    } while (false)
+
+#define INSTR_REPORT(path) ::instr::Registry::instance().dump(path)
+
+#else
+
+#define INSTR_SCOPE(name) ((void)0)
+#define INSTR_COUNT(name, delta) ((void)0)
+#define INSTR_REPORT(path) ((void)0)
+
+#endif
@@ -3,28 +3,89 @@
 #include <vector>
 #include <ctime>
 #include <iomanip>
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <source_location>
+#include <thread>
+#include "Instrumentation.h"
 
 class Log {
 public:
     // Уровни важности событий
     enum Level { NORMAL, WARNING, ERROR };
     
+    // Фильтр уровня. sampleRate - доля сохраняемых сообщений (случайная
+    // выборка). rate и burst - token bucket на каждое место вызова: в среднем
+    // rate сообщений в секунду, подряд не больше burst (rate == 0 - без
+    // ограничения). Одинаковые сообщения одного места вызова в пределах
+    // repeatWindow секунд сворачиваются в "last message repeated N times"
+    struct Policy {
+        double sampleRate = 1.0;
+        double rate = 0;
+        double burst = 0;
+        double repeatWindow = 0;
+    };
+
     // Получение экземпляра синглтона
     static Log& getInstance() {
         static Log instance;
         return instance;
     }
     
-    // Добавление сообщения в лог
-    void message(Level level, const std::string& msg) {
-        entries.emplace_back(std::time(nullptr), level, msg);
-        if (entries.size() > MAX_ENTRIES) {
-            entries.erase(entries.begin());
+    // Настройка уровня; вызывать до того, как начнут писать другие потоки
+    void setPolicy(Level level, const Policy& policy) {
+        policies[level] = policy;
+    }
+
+    // Добавление сообщения в лог. Можно вызывать из разных потоков: фильтр
+    // работает без блокировок, мьютекс берут только прошедшие его сообщения.
+    // Отброшенные сообщения учитываются и попадают в лог сводкой перед
+    // следующим сообщением того же места вызова
+    void message(Level level, const std::string& msg,
+                 std::source_location where = std::source_location::current()) {
+        INSTR_SCOPE("Log::message");
+        Site& site = siteOf(where, level);
+        const Policy& policy = policies[level];
+        if (policy.sampleRate < 1.0 && !sampled(policy.sampleRate)) {
+            suppress(site);
+            return;
+        }
+        // Часы и хеш текста нужны только включённым фильтрам
+        if (policy.rate > 0 || policy.repeatWindow > 0) {
+            std::int64_t now = coarseNow();
+            std::uint64_t text = policy.repeatWindow > 0 ? std::hash<std::string>{}(msg) : 0;
+            if (policy.repeatWindow > 0 && site.lastText.load(std::memory_order_relaxed) == text &&
+                now - site.lastStored.load(std::memory_order_relaxed) < toNanoseconds(policy.repeatWindow)) {
+                site.repeats.fetch_add(1, std::memory_order_relaxed);
+                INSTR_COUNT("Log::collapsed", 1);
+                return;
+            }
+            if (!takeToken(site, policy, now)) {
+                suppress(site);
+                return;
+            }
+            site.lastText.store(text, std::memory_order_relaxed);
+            site.lastStored.store(now, std::memory_order_relaxed);
         }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        flushSummary(site);
+        store(level, msg);
     }
     
     // Вывод последних сообщений
     void print() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Site& site : sites) {
+            if (site.key.load(std::memory_order_acquire) & 1) flushSummary(site);
+        }
+        flushSummary(overflow);
         std::cout << "=== Last " << MAX_ENTRIES << " log entries ===" << std::endl;
         for (const auto& [time, level, message] : entries) {
             char timeStr[20];
@@ -53,8 +114,145 @@ private:
         Entry(std::time_t t, Level l, const std::string& m) : time(t), level(l), message(m) {}
     };
     
+    // Состояние места вызова. Ключ - хеш файла, строки и столбца (всегда нечётный),
+    // 0 - свободная ячейка, CLAIMING - ячейка занята, но поля ещё заполняются.
+    // level - уровень сводок; у overflow (file == nullptr) - наибольший из встреченных
+    struct Site {
+        std::atomic<std::uint64_t> key{0};
+        std::atomic<const char*> file{nullptr};
+        std::atomic<std::uint32_t> line{0};
+        std::atomic<Level> level{NORMAL};
+        std::atomic<std::int64_t> nextAllowed{0};  // token bucket в форме GCRA, нс
+        std::atomic<std::uint64_t> lastText{0};
+        std::atomic<std::int64_t> lastStored{0};
+        std::atomic<std::uint64_t> repeats{0};
+        std::atomic<std::uint64_t> suppressed{0};
+    };
+
+    static constexpr size_t SITES = 256;
+    static constexpr size_t MAX_PROBES = 16;
+    static constexpr std::uint64_t CLAIMING = 2;
+
+    // Монотонное время в нс. Грубые часы (шаг в несколько миллисекунд)
+    // читаются в разы быстрее точных, а фильтрам их точности хватает
+    static std::int64_t coarseNow() {
+#ifdef CLOCK_MONOTONIC_COARSE
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return std::int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    static std::int64_t toNanoseconds(double seconds) {
+        return static_cast<std::int64_t>(seconds * 1e9);
+    }
+
+    // Хеш-таблица мест вызова с открытой адресацией: ячейка занимается CAS
+    // 0 -> CLAIMING, заполняется и публикуется записью ключа, после чего больше
+    // не освобождается. Поток, заставший ячейку в CLAIMING, ждёт публикации:
+    // ключ может оказаться его собственным. Если за MAX_PROBES проб места нет,
+    // место вызова попадает в общую ячейку overflow вместе со всеми такими же:
+    // ограничения и сводка у них общие
+    Site& siteOf(const std::source_location& where, Level level) {
+        std::uint64_t key = reinterpret_cast<std::uintptr_t>(where.file_name()) * 0x9E3779B97F4A7C15ull ^
+                            (std::uint64_t(where.line()) << 32 | where.column());
+        key = (key ^ (key >> 29)) | 1;
+        for (size_t probe = 0; probe < MAX_PROBES; ++probe) {
+            Site& site = sites[(key + probe) % SITES];
+            std::uint64_t seen = site.key.load(std::memory_order_acquire);
+            if (seen == 0 && site.key.compare_exchange_strong(seen, CLAIMING, std::memory_order_acquire)) {
+                site.file.store(where.file_name(), std::memory_order_relaxed);
+                site.line.store(where.line(), std::memory_order_relaxed);
+                site.level.store(level, std::memory_order_relaxed);
+                site.key.store(key, std::memory_order_release);
+                return site;
+            }
+            while (seen == CLAIMING) {
+                std::this_thread::yield();
+                seen = site.key.load(std::memory_order_acquire);
+            }
+            if (seen == key) return site;
+        }
+        Level seen = overflow.level.load(std::memory_order_relaxed);
+        while (seen < level && !overflow.level.compare_exchange_weak(seen, level, std::memory_order_relaxed)) {
+        }
+        return overflow;
+    }
+
+    // Токен из ведра места вызова: nextAllowed - время, когда ведро снова
+    // будет полным; запрос проходит, если оно не дальше burst интервалов
+    static bool takeToken(Site& site, const Policy& policy, std::int64_t now) {
+        if (policy.rate <= 0) return true;
+        std::int64_t interval = toNanoseconds(1.0 / policy.rate);
+        std::int64_t tolerance = static_cast<std::int64_t>(interval * std::max(policy.burst - 1, 0.0));
+        std::int64_t next = site.nextAllowed.load(std::memory_order_relaxed);
+        while (true) {
+            std::int64_t start = std::max(next, now);
+            if (start - now > tolerance) return false;
+            if (site.nextAllowed.compare_exchange_weak(next, start + interval, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    // Выборка: xorshift в каждом потоке, без общих записей
+    static bool sampled(double rate) {
+        thread_local std::uint64_t state =
+            0x2545F4914F6CDD1Dull ^ reinterpret_cast<std::uintptr_t>(&state);
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<double>(state >> 11) * 0x1.0p-53 < rate;
+    }
+
+    static void suppress(Site& site) {
+        site.suppressed.fetch_add(1, std::memory_order_relaxed);
+        INSTR_COUNT("Log::suppressed", 1);
+    }
+
+    // Сводка по отброшенным сообщениям места вызова (под мьютексом)
+    void flushSummary(Site& site) {
+        if (site.repeats.load(std::memory_order_relaxed) == 0 &&
+            site.suppressed.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        std::uint64_t repeats = site.repeats.exchange(0, std::memory_order_relaxed);
+        std::uint64_t suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+        if (repeats == 0 && suppressed == 0) return;
+        std::string summary;
+        if (const char* file = site.file.load(std::memory_order_acquire)) {
+            const char* slash = std::strrchr(file, '/');
+            summary = slash ? slash + 1 : file;
+            summary += ":" + std::to_string(site.line.load(std::memory_order_acquire)) + ": ";
+        } else {
+            summary = "other call sites (site table full): ";
+        }
+        if (repeats != 0) summary += "last message repeated " + std::to_string(repeats) + " times";
+        if (repeats != 0 && suppressed != 0) summary += ", ";
+        if (suppressed != 0) summary += std::to_string(suppressed) + " similar messages suppressed";
+        store(site.level.load(std::memory_order_relaxed), summary);
+    }
+
+    void store(Level level, const std::string& msg) {
+        entries.emplace_back(std::time(nullptr), level, msg);
+        if (entries.size() > MAX_ENTRIES) {
+            entries.erase(entries.begin());
+            INSTR_COUNT("Log::evicted", 1);
+        }
+    }
+
+    std::mutex mutex;
     std::vector<Entry> entries;
     static const size_t MAX_ENTRIES = 10;
+
+    // Обычные сообщения: до 5 подряд и 10 в секунду с одного места вызова,
+    // предупреждения: 10 и 20, ошибки не ограничиваются
+    std::array<Policy, 3> policies = {{{1.0, 10, 5, 1.0}, {1.0, 20, 10, 1.0}, {1.0, 0, 0, 1.0}}};
+    std::array<Site, SITES> sites{};
+    Site overflow;
 };
 
 // Пример использования
@@ -69,10 +267,14 @@ int main() {
     Log &log2 = Log::getInstance();
     log2.print(); // тот же объект
 
-    //ограниченность хранящихся записей
+    //ограниченность хранящихся записей: поток сообщений с одного места
+    //вызова сворачивается в сводку и не вытесняет ошибку
     for (int i = 1; i <= 12; ++i) {
         Log::getInstance().message(Log::NORMAL, "Processing item " + std::to_string(i));
     }
+    for (int i = 1; i <= 1000; ++i) {
+        Log::getInstance().message(Log::WARNING, "Low memory detected");
+    }
     
     Log::getInstance().print();
     
@@ -1,5 +1,15 @@
 #include <iostream>
 #include <cassert>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 // Реализация less_than_comparable
 template <typename Derived>
@@ -42,6 +52,233 @@ private:
     inline static size_t count_ = 0;
 };
 
+// Реализация pooled: operator new/delete класса берут память из пула
+// объектов этого класса. У каждого потока свой список свободных мест и
+// текущий блок (slab), из которого места нарезаются по порядку, поэтому
+// обычные new/delete не берут блокировок и не обращаются к malloc.
+// Общее состояние (блоки, свободные места завершившихся потоков, счётчики)
+// под мьютексом и трогается только при нехватке мест. Объект можно удалить
+// в другом потоке - место попадёт в список этого потока. Наследники
+// Derived другого размера получают память от глобального operator new.
+// Завершение: кэш потока (thread_local) уничтожается раньше статических
+// объектов, поэтому после этого new/delete в потоке идут в общий список под
+// мьютексом. Общее состояние намеренно не разрушается, и блоки не
+// освобождаются до выхода из процесса - объекты, удаляемые деструкторами
+// статических объектов, не повисают
+template <typename Derived>
+class pooled {
+public:
+    struct stats {
+        size_t slabs;          // блоков памяти
+        size_t capacity;       // мест для объектов в блоках
+        size_t allocations;    // объектов выдано из пула
+        size_t deallocations;  // объектов возвращено в пул
+        size_t live;           // живых объектов: counter<Derived>, если он есть у класса
+    };
+
+    static void* operator new(std::size_t size) {
+        if (size != sizeof(Derived)) return ::operator new(size);
+        if (cache_retired()) return shared().allocate();
+        return cache().allocate();
+    }
+
+    static void operator delete(void* ptr, std::size_t size) {
+        if (ptr == nullptr) return;
+        if (size != sizeof(Derived)) {
+            ::operator delete(ptr);
+            return;
+        }
+        if (cache_retired()) {
+            shared().deallocate(ptr);
+            return;
+        }
+        cache().deallocate(ptr);
+    }
+
+    static stats pool_stats() {
+        Shared& state = shared();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        stats result{state.slabs.size(), state.slabs.size() * slab_objects(),
+                     state.retiredAllocations, state.retiredDeallocations, 0};
+        for (const ThreadCache* cache : state.caches) {
+            result.allocations += cache->allocations.load(std::memory_order_relaxed);
+            result.deallocations += cache->deallocations.load(std::memory_order_relaxed);
+        }
+        if constexpr (std::is_base_of_v<counter<Derived>, Derived>) {
+            result.live = counter<Derived>::count();
+        } else {
+            result.live = result.allocations - result.deallocations;
+        }
+        return result;
+    }
+
+private:
+    struct Node {
+        Node* next;
+    };
+
+    static constexpr size_t object_size() {
+        size_t size = std::max(sizeof(Derived), sizeof(Node));
+        size_t align = std::max(alignof(Derived), alignof(Node));
+        return (size + align - 1) / align * align;
+    }
+
+    static constexpr std::align_val_t slab_align() {
+        return std::align_val_t{std::max(alignof(Derived), alignof(Node))};
+    }
+
+    // Блок около 64 КиБ, но не меньше 64 объектов
+    static constexpr size_t slab_objects() {
+        return std::max<size_t>(64, (64 * 1024) / object_size());
+    }
+
+    struct ThreadCache;
+
+    struct Shared {
+        std::mutex mutex;
+        std::vector<void*> slabs;
+        Node* orphans = nullptr;            // свободные места, отданные потоками
+        std::vector<ThreadCache*> caches;
+        size_t retiredAllocations = 0;      // счётчики завершившихся потоков
+        size_t retiredDeallocations = 0;
+
+        // Выделение и освобождение мимо кэша - для потоков, чей кэш уже уничтожен
+        void* allocate() {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++retiredAllocations;
+            if (orphans == nullptr) {
+                char* slab = newSlab();
+                for (size_t i = slab_objects(); i-- > 1;) {
+                    Node* node = reinterpret_cast<Node*>(slab + i * object_size());
+                    node->next = orphans;
+                    orphans = node;
+                }
+                return slab;
+            }
+            Node* node = orphans;
+            orphans = node->next;
+            return node;
+        }
+
+        void deallocate(void* ptr) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++retiredDeallocations;
+            Node* node = static_cast<Node*>(ptr);
+            node->next = orphans;
+            orphans = node;
+        }
+
+        // Новый блок (под мьютексом)
+        char* newSlab() {
+            char* slab = static_cast<char*>(::operator new(slab_objects() * object_size(), slab_align()));
+            slabs.push_back(slab);
+            return slab;
+        }
+    };
+
+    // Не разрушается: нужно и деструкторам статических объектов
+    static Shared& shared() {
+        static Shared* state = new Shared;
+        return *state;
+    }
+
+    // Кэш этого потока уже уничтожен. bool без деструктора доступен до конца потока
+    static bool& cache_retired() {
+        thread_local bool retired = false;
+        return retired;
+    }
+
+    struct ThreadCache {
+        Node* free = nullptr;
+        size_t freeCount = 0;
+        char* cursor = nullptr;   // нетронутый остаток текущего блока
+        char* end = nullptr;
+        // Пишет только поток-владелец; atomic - чтобы pool_stats читал без гонки
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> deallocations{0};
+
+        ThreadCache() {
+            Shared& state = shared();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.caches.push_back(this);
+        }
+
+        ~ThreadCache() {
+            for (; cursor != end; cursor += object_size()) push(cursor);
+            Shared& state = shared();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            donate(state);
+            state.retiredAllocations += allocations.load(std::memory_order_relaxed);
+            state.retiredDeallocations += deallocations.load(std::memory_order_relaxed);
+            std::erase(state.caches, this);
+            cache_retired() = true;
+        }
+
+        void* allocate() {
+            allocations.store(allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (free == nullptr && cursor == end) refill();
+            if (free != nullptr) {
+                Node* node = free;
+                free = node->next;
+                --freeCount;
+                return node;
+            }
+            void* ptr = cursor;
+            cursor += object_size();
+            return ptr;
+        }
+
+        void deallocate(void* ptr) {
+            deallocations.store(deallocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            push(ptr);
+            // Поток, который только освобождает чужие объекты, не копит их без предела
+            if (freeCount > 4 * slab_objects()) {
+                Shared& state = shared();
+                std::lock_guard<std::mutex> lock(state.mutex);
+                donate(state);
+            }
+        }
+
+        void push(void* ptr) {
+            Node* node = static_cast<Node*>(ptr);
+            node->next = free;
+            free = node;
+            ++freeCount;
+        }
+
+        // Отдать все свободные места в общий список (под мьютексом)
+        void donate(Shared& state) {
+            if (free == nullptr) return;
+            Node* last = free;
+            while (last->next != nullptr) last = last->next;
+            last->next = state.orphans;
+            state.orphans = free;
+            free = nullptr;
+            freeCount = 0;
+        }
+
+        // Забрать свободные места у завершившихся потоков или выделить новый блок
+        void refill() {
+            Shared& state = shared();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.orphans != nullptr) {
+                free = state.orphans;
+                state.orphans = nullptr;
+                for (Node* node = free; node != nullptr; node = node->next) ++freeCount;
+                return;
+            }
+            char* slab = state.newSlab();
+            cursor = slab;
+            end = slab + slab_objects() * object_size();
+        }
+    };
+
+    static ThreadCache& cache() {
+        thread_local ThreadCache local;
+        return local;
+    }
+};
+
 // Класс Number, использующий оба MixIn
 class Number : public less_than_comparable<Number>, public counter<Number> {
 public:
@@ -57,7 +294,72 @@ private:
     int m_value;
 };
 
-int main() {
+// Бенчмарк: "рабочий набор" из live объектов, случайный объект удаляется и
+// создаётся заново - обычный new/delete против pooled. Затем один поток
+// создаёт объекты, другой удаляет
+struct Particle : pooled<Particle> {
+    double position[3];
+    double velocity[3];
+    int id;
+};
+
+struct PlainParticle {
+    double position[3];
+    double velocity[3];
+    int id;
+};
+
+template <typename T>
+double churn(size_t live, size_t operations) {
+    std::vector<T*> objects(live);
+    for (auto& object : objects) object = new T{};
+    std::mt19937 rng(1);
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < operations; ++i) {
+        T*& slot = objects[rng() % live];
+        delete slot;
+        slot = new T{};
+        slot->id = static_cast<int>(i);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    for (T* object : objects) delete object;
+    return ns / operations;
+}
+
+void run_benchmark() {
+    for (size_t live : {100, 10000, 1000000}) {
+        double plain = churn<PlainParticle>(live, 20000000);
+        double pool = churn<Particle>(live, 20000000);
+        std::cout << "live " << live << ": new/delete " << plain << " ns, pooled " << pool << " ns\n";
+    }
+
+    std::vector<Particle*> handoff(1000000);
+    std::thread producer([&] {
+        for (auto& object : handoff) object = new Particle{};
+    });
+    producer.join();
+    std::thread consumer([&] {
+        for (Particle* object : handoff) delete object;
+    });
+    consumer.join();
+    auto stats = Particle::pool_stats();
+    std::cout << "pool: " << stats.slabs << " slabs, " << stats.capacity << " places, "
+              << stats.allocations << " allocations, " << stats.deallocations << " deallocations, "
+              << stats.live << " live\n";
+}
+
+// Number с пулом: counter даёт число живых объектов для статистики пула
+class PooledNumber : public Number, public pooled<PooledNumber>, public counter<PooledNumber> {
+public:
+    using Number::Number;
+};
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && std::strcmp(argv[1], "--bench") == 0) {
+        run_benchmark();
+        return 0;
+    }
+
     Number one{1};
     Number two{2};
     Number three{3};
@@ -76,6 +378,14 @@ int main() {
     Number five{5};
     
     std::cout << "Count after add number five: " << counter<Number>::count() << std::endl; // Теперь 5
+
+    // Объекты из пула
+    std::vector<std::unique_ptr<PooledNumber>> numbers;
+    for (int i = 0; i < 1000; ++i) numbers.push_back(std::make_unique<PooledNumber>(i));
+    numbers.resize(10);
+    auto stats = PooledNumber::pool_stats();
+    std::cout << "Pool: " << stats.live << " live, " << stats.allocations << " allocations, "
+              << stats.slabs << " slabs" << std::endl; // 10 живых из 1000 выданных
     
     return 0;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <optional>
 #include <any>
 #include <iostream>
+#include "Instrumentation.h"
 
 namespace TypeListDetail {
     template <typename... Types>
@@ -91,6 +92,7 @@ struct TypeMap<Head, Tail...>
 
     template<typename T> T getValue()
     {
+        INSTR_SCOPE("TypeMap::getValue");
         int i = TypeListDetail::IndexOf<T, keys>::value;
         if (values[i]) {
             T from_any = std::any_cast<T>(values[i].value());
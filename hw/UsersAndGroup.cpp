@@ -2,27 +2,231 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <string_view>
+#include <charconv>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <type_traits>
+#include <fstream>
+#include <cstdio>
+#include <csignal>
+#include <sstream>
+#include <deque>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Instrumentation.h"
+
+// Буфер для массового вывода: поля форматируются в память (числа через
+// std::to_chars), а в поток данные уходят крупными блоками
+class OutputBuffer {
+public:
+    static constexpr size_t CAPACITY = 1 << 20;
+
+    explicit OutputBuffer(std::ostream& sink) : sink(sink) { data.reserve(CAPACITY + 4096); }
+    ~OutputBuffer() { flush(); }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    OutputBuffer& operator<<(std::string_view s) {
+        data.append(s);
+        if (data.size() >= CAPACITY) flush();
+        return *this;
+    }
+
+    OutputBuffer& operator<<(char c) {
+        data.push_back(c);
+        return *this;
+    }
+
+    template <typename Int, std::enable_if_t<std::is_integral_v<Int> && !std::is_same_v<Int, char>, int> = 0>
+    OutputBuffer& operator<<(Int value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        data.append(digits, result.ptr);
+        return *this;
+    }
+
+    void flush() {
+        if (!data.empty()) {
+            sink.write(data.data(), static_cast<std::streamsize>(data.size()));
+            data.clear();
+        }
+    }
+
+private:
+    std::ostream& sink;
+    std::string data;
+};
+
+// Экранирование строк для экспорта в JSON и CSV
+void writeJsonEscaped(OutputBuffer& out, std::string_view s) {
+    size_t start = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c != '"' && c != '\\' && c >= 0x20) continue;
+        out << s.substr(start, i - start);
+        if (c == '"') out << "\\\"";
+        else if (c == '\\') out << "\\\\";
+        else {
+            const char hex[] = "0123456789abcdef";
+            out << "\\u00" << hex[c >> 4] << hex[c & 0xF];
+        }
+        start = i + 1;
+    }
+    out << s.substr(start);
+}
+
+void writeJsonString(OutputBuffer& out, std::string_view s) {
+    out << '"';
+    writeJsonEscaped(out, s);
+    out << '"';
+}
+
+void writeCsvField(OutputBuffer& out, std::string_view s) {
+    if (s.find_first_of(",\"\n") == std::string_view::npos) {
+        out << s;
+        return;
+    }
+    out << '"';
+    for (char c : s) {
+        if (c == '"') out << '"';
+        out << c;
+    }
+    out << '"';
+}
+
+enum class ExportFormat { Csv, Json };
+
+// Арена для строк: байты копируются в крупные непрерывные блоки, а наружу
+// отдаются string_view. Отдельные строки не освобождаются - память
+// возвращается только вместе с ареной (UserGroupManager при checkpoint
+// переносит живые строки в новую арену)
+class StringArena {
+public:
+    std::string_view store(std::string_view s) {
+        if (s.empty()) return {};
+        if (s.size() > BLOCK_SIZE / 4) {
+            // Длинная строка получает свой блок, чтобы не тратить остаток текущего
+            blocks.push_back(std::make_unique<char[]>(s.size()));
+            reserved += s.size();
+            std::memcpy(blocks.back().get(), s.data(), s.size());
+            return {blocks.back().get(), s.size()};
+        }
+        if (capacity - used < s.size()) {
+            blocks.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+            reserved += BLOCK_SIZE;
+            current = blocks.back().get();
+            used = 0;
+            capacity = BLOCK_SIZE;
+        }
+        char* dst = current + used;
+        std::memcpy(dst, s.data(), s.size());
+        used += s.size();
+        return {dst, s.size()};
+    }
+
+    size_t bytesReserved() const { return reserved; }
+
+    // Освобождение всех блоков: выданные string_view становятся недействительными
+    void clear() {
+        blocks.clear();
+        current = nullptr;
+        used = capacity = reserved = 0;
+    }
+
+    // Забрать блоки другой арены: строки остаются на своих местах, поэтому
+    // string_view, выданные ею, остаются действительными
+    void absorb(StringArena& other) {
+        for (auto& block : other.blocks) blocks.push_back(std::move(block));
+        reserved += other.reserved;
+        other.blocks.clear();
+        other.current = nullptr;
+        other.used = other.capacity = other.reserved = 0;
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* current = nullptr;
+    size_t used = 0;
+    size_t capacity = 0;
+    size_t reserved = 0;
+};
+
+// Интернирование повторяющихся строк (доменов почты): одинаковые значения
+// хранятся в арене один раз
+class StringInterner {
+public:
+    explicit StringInterner(StringArena& arena) : arena(arena) {}
+
+    std::string_view intern(std::string_view s) {
+        auto it = pool.find(s);
+        if (it != pool.end()) return *it;
+        std::string_view stored = arena.store(s);
+        pool.insert(stored);
+        return stored;
+    }
+
+    size_t size() const { return pool.size(); }
+
+    void clear() { pool.clear(); }
+
+    // Добавить строки другого интернатора. Его строки должны жить не меньше
+    // наших (арена другого поглощена нашей)
+    void merge(const StringInterner& other) {
+        pool.insert(other.pool.begin(), other.pool.end());
+    }
+
+private:
+    StringArena& arena;
+    std::unordered_set<std::string_view> pool;
+};
 
 // Предварительное объявление класса Group
 class Group;
 
+// Строковые поля пользователя указывают в арену UserGroupManager. Адрес почты
+// хранится двумя частями: уникальная часть до домена (вместе с '@') и
+// интернированный домен, общий для всех адресов этого домена
 class User {
 private:
-    std::string userId;
-    std::string username;
-    std::string email;
+    std::string_view userId;
+    std::string_view username;
+    std::string_view emailLocal;
+    std::string_view emailDomain;
     int age;
     Group* group;
 
 public:
-    User(const std::string& id, const std::string& name, const std::string& email, int age);
+    User(std::string_view id, std::string_view name,
+         std::string_view emailLocal, std::string_view emailDomain, int age);
 
     // Геттеры
-    const std::string& getId() const { return userId; }
-    const std::string& getUsername() const { return username; }
-    const std::string& getEmail() const { return email; }
+    std::string_view getId() const { return userId; }
+    std::string_view getUsername() const { return username; }
+    std::string getEmail() const { return std::string(emailLocal).append(emailDomain); }
+    std::string_view getEmailLocal() const { return emailLocal; }
+    std::string_view getEmailDomain() const { return emailDomain; }
+    size_t getEmailSize() const { return emailLocal.size() + emailDomain.size(); }
     int getAge() const { return age; }
     Group* getGroup() const { return group; }
 
@@ -31,6 +235,15 @@ public:
     void removeGroup() { group = nullptr; }
 
     void printInfo() const;
+    void format(OutputBuffer& out) const;
+
+    // Копирование строк в другую арену (сжатие арены менеджера)
+    void moveStrings(StringArena& arena, StringInterner& domains) {
+        userId = arena.store(userId);
+        username = arena.store(username);
+        emailLocal = arena.store(emailLocal);
+        emailDomain = domains.intern(emailDomain);
+    }
 };
 
 class Group {
@@ -45,14 +258,30 @@ public:
     const std::string& getId() const { return groupId; }
     const std::vector<User*>& getUsers() const { return users; }
 
-    // Добавление пользователя в группу
+    // Добавление пользователя в группу. Пользователь состоит не больше чем
+    // в одной группе, поэтому из предыдущей он удаляется
     void addUser(User* user) {
-        if (user && std::find(users.begin(), users.end(), user) == users.end()) {
+        INSTR_SCOPE("Group::addUser");
+        if (user && user->getGroup() != this) {
+            if (Group* previous = user->getGroup()) previous->removeUser(user);
             users.push_back(user);
             user->setGroup(this);
         }
     }
 
+    // Добавление без проверки на повтор (восстановление из снимка, где
+    // списки участников уже без дубликатов)
+    void addUserUnchecked(User* user) {
+        users.push_back(user);
+        user->setGroup(this);
+    }
+
+    // Добавление сразу count новых пользователей (массовая загрузка)
+    void addUsersUnchecked(User* const* first, size_t count) {
+        users.insert(users.end(), first, first + count);
+        for (size_t i = 0; i < count; ++i) first[i]->setGroup(this);
+    }
+
     // Удаление пользователя из группы
     void removeUser(User* user) {
         auto it = std::find(users.begin(), users.end(), user);
@@ -63,52 +292,305 @@ public:
     }
 
     void printInfo() const {
-        std::cout << "Group ID: " << groupId << "\n";
-        std::cout << "Members (" << users.size() << "):\n";
+        OutputBuffer out(std::cout);
+        format(out);
+    }
+
+    void format(OutputBuffer& out) const {
+        out << "Group ID: " << groupId << '\n';
+        out << "Members (" << users.size() << "):\n";
         for (const auto& user : users) {
-            std::cout << "  - " << user->getUsername() << " (ID: " << user->getId() << ")\n";
+            out << "  - " << user->getUsername() << " (ID: " << user->getId() << ")\n";
         }
-        std::cout << "------------------\n";
+        out << "------------------\n";
     }
 };
 
 // Реализация методов User после определения Group
-User::User(const std::string& id, const std::string& name, const std::string& email, int age)
-    : userId(id), username(name), email(email), age(age), group(nullptr) {}
+User::User(std::string_view id, std::string_view name,
+           std::string_view emailLocal, std::string_view emailDomain, int age)
+    : userId(id), username(name), emailLocal(emailLocal), emailDomain(emailDomain),
+      age(age), group(nullptr) {}
 
 void User::setGroup(Group* newGroup) {
     group = newGroup;
 }
 
 void User::printInfo() const {
-    std::cout << "User ID: " << userId << "\n";
-    std::cout << "Username: " << username << "\n";
-    std::cout << "Email: " << email << "\n";
-    std::cout << "Age: " << age << "\n";
+    OutputBuffer out(std::cout);
+    format(out);
+}
+
+void User::format(OutputBuffer& out) const {
+    out << "User ID: " << userId << '\n';
+    out << "Username: " << username << '\n';
+    out << "Email: " << emailLocal << emailDomain << '\n';
+    out << "Age: " << age << '\n';
     if (group) {
-        std::cout << "Group ID: " << group->getId() << "\n";
+        out << "Group ID: " << group->getId() << '\n';
     } else {
-        std::cout << "Not in any group\n";
+        out << "Not in any group\n";
     }
-    std::cout << "------------------\n";
+    out << "------------------\n";
+}
+
+// Хеш строк с поддержкой поиска по std::string_view без создания временной строки
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+// fsync файла или каталога по пути (данные и метаданные - на диск)
+bool syncPath(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool synced = fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+std::string parentDirectory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos) return ".";
+    return slash == 0 ? "/" : path.substr(0, slash);
 }
 
+// Журнал изменяющих команд (write-ahead log). Команды хранятся в том же
+// текстовом виде, что и ввод, по одной на строку; запись целая, только если
+// дописан её '\n' (восстановление - replayLog)
+class WriteAheadLog {
+public:
+    WriteAheadLog() = default;
+    ~WriteAheadLog() { close(); }
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    bool open(const std::string& logPath) {
+        close();
+        file = std::fopen(logPath.c_str(), "ab");
+        if (!file) return false;
+        std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+        return true;
+    }
+
+    void close() {
+        if (file) {
+            sync();
+            std::fclose(file);
+            file = nullptr;
+        }
+    }
+
+    void append(std::string_view command) {
+        std::fwrite(command.data(), 1, command.size(), file);
+        std::fputc('\n', file);
+    }
+
+    // Сброс буфера в ОС (переживает падение процесса)
+    void flush() { std::fflush(file); }
+
+    // Сброс на диск (переживает падение системы)
+    void sync() {
+        flush();
+        fsync(fileno(file));
+    }
+
+    // Очистка журнала после записи снимка. Файл обрезается через тот же
+    // дескриптор: журнал открыт на дозапись, и следующие команды пойдут с
+    // начала. При ошибке журнал остаётся открытым и целым
+    bool truncate() {
+        if (std::fflush(file) != 0) return false;
+        return ftruncate(fileno(file), 0) == 0;
+    }
+
+private:
+    std::FILE* file = nullptr;
+};
+
+// Запись значения фиксированного размера в двоичный снимок
+template <typename T>
+void writePod(OutputBuffer& out, const T& value) {
+    out << std::string_view(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writeSnapshotString(OutputBuffer& out, std::string_view s) {
+    writePod(out, static_cast<std::uint32_t>(s.size()));
+    out << s;
+}
+
+// Чтение двоичного снимка из отображённой в память области с проверкой границ
+class SnapshotReader {
+public:
+    SnapshotReader(const char* data, size_t size) : pos(data), end(data + size) {}
+
+    template <typename T>
+    T pod() {
+        T value{};
+        if (static_cast<size_t>(end - pos) < sizeof(T)) {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string_view string() {
+        std::uint32_t len = pod<std::uint32_t>();
+        if (!ok || static_cast<size_t>(end - pos) < len) {
+            ok = false;
+            return {};
+        }
+        std::string_view s(pos, len);
+        pos += len;
+        return s;
+    }
+
+    bool good() const { return ok; }
+
+private:
+    const char* pos;
+    const char* end;
+    bool ok = true;
+};
+
+// Простой пул потоков. parallelFor раздаёт номера задач 0..count-1 рабочим
+// потокам и вызывающему потоку и возвращается после выполнения всех задач
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+        for (size_t i = 1; i < threads; ++i) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    void parallelFor(size_t count, const std::function<void(size_t)>& task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = &task;
+            taskCount = count;
+            next = 0;
+            active = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+        runTasks(task, count);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return active == 0; });
+        current = nullptr;
+    }
+
+private:
+    void runTasks(const std::function<void(size_t)>& task, size_t count) {
+        for (size_t i = next++; i < count; i = next++) {
+            task(i);
+        }
+    }
+
+    void workerLoop() {
+        size_t seen = 0;
+        while (true) {
+            const std::function<void(size_t)>* task;
+            size_t count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                task = current;
+                count = taskCount;
+            }
+            runTasks(*task, count);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--active == 0) done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* current = nullptr;
+    size_t taskCount = 0;
+    std::atomic<size_t> next{0};
+    size_t active = 0;
+    size_t generation = 0;
+    bool stopping = false;
+};
+
+// Пакет для массовой загрузки: столбцы одной длины, строка i - пользователь
+// ids[i] в группе groupIds[i] (пустая строка - без группы). Строки копируются
+// в арену менеджера, так что пакет достаточно держать до конца bulkLoad
+struct UserColumns {
+    std::vector<std::string_view> ids;
+    std::vector<std::string_view> names;
+    std::vector<std::string_view> emails;
+    std::vector<int> ages;
+    std::vector<std::string_view> groupIds;
+
+    size_t size() const { return ids.size(); }
+    bool consistent() const {
+        return names.size() == ids.size() && emails.size() == ids.size() &&
+               ages.size() == ids.size() && groupIds.size() == ids.size();
+    }
+};
+
 // Класс для управления пользователями и группами
 class UserGroupManager {
 private:
-    std::unordered_map<std::string, std::unique_ptr<User>> users;
-    std::unordered_map<std::string, std::unique_ptr<Group>> groups;
+    template <typename T>
+    using Index = std::unordered_map<std::string, std::unique_ptr<T>, StringHash, std::equal_to<>>;
+    // Ключи пользователей указывают на userId в арене
+    using UserIndex = std::unordered_map<std::string_view, std::unique_ptr<User>>;
+
+    // Арена объявлена до пользователей: строки должны пережить объекты User
+    StringArena arena;
+    StringInterner domains{arena};
+
+    UserIndex users;
+    Index<Group> groups;
+
+    // Хранилище состояния: путь к снимку и журнал изменений (если подключены)
+    std::string snapshotPath;
+    WriteAheadLog* wal = nullptr;
+
+    // Формат снимка: заголовок, группы, пользователи, списки участников групп
+    // (индексы пользователей). Числа хранятся в порядке байтов машины
+    static constexpr char SNAPSHOT_MAGIC[8] = {'U', 'G', 'S', 'N', 'A', 'P', '0', '1'};
 
 public:
     // Методы для работы с пользователями
-    bool createUser(const std::string& userId, const std::string& username, 
-                   const std::string& email, int age) {
+    bool createUser(std::string_view userId, std::string_view username,
+                   std::string_view email, int age) {
         if (users.find(userId) != users.end()) return false;
-        users[userId] = std::make_unique<User>(userId, username, email, age);
+        auto user = makeUser(userId, username, email, age);
+        users.emplace(user->getId(), std::move(user));
         return true;
     }
 
-    bool deleteUser(const std::string& userId) {
+    // Память под строки пользователей и число различных доменов почты
+    size_t stringBytesReserved() const { return arena.bytesReserved(); }
+    size_t distinctEmailDomains() const { return domains.size(); }
+
+    bool deleteUser(std::string_view userId) {
         auto it = users.find(userId);
         if (it == users.end()) return false;
 
@@ -121,30 +603,83 @@ public:
         return true;
     }
 
-    void printAllUsers() const {
-        std::cout << "All Users (" << users.size() << "):\n";
+    void printAllUsers(std::ostream& stream = std::cout) const {
+        OutputBuffer out(stream);
+        out << "All Users (" << users.size() << "):\n";
         for (const auto& pair : users) {
-            pair.second->printInfo();
+            pair.second->format(out);
         }
     }
 
-    void printUser(const std::string& userId) const {
+    void printUser(std::string_view userId, std::ostream& stream = std::cout) const {
+        OutputBuffer out(stream);
         auto it = users.find(userId);
         if (it != users.end()) {
-            it->second->printInfo();
+            it->second->format(out);
         } else {
-            std::cout << "User not found.\n";
+            out << "User not found.\n";
+        }
+    }
+
+    // Потоковый экспорт всех пользователей в CSV или JSON через общий буфер вывода
+    void exportUsers(std::ostream& stream, ExportFormat format) const {
+        OutputBuffer out(stream);
+        if (format == ExportFormat::Csv) {
+            out << "userId,username,email,age,groupId\n";
+            for (const auto& pair : users) {
+                const User& user = *pair.second;
+                writeCsvField(out, user.getId());
+                out << ',';
+                writeCsvField(out, user.getUsername());
+                out << ',';
+                if (user.getEmailLocal().find_first_of(",\"\n") == std::string_view::npos &&
+                    user.getEmailDomain().find_first_of(",\"\n") == std::string_view::npos) {
+                    out << user.getEmailLocal() << user.getEmailDomain();
+                } else {
+                    writeCsvField(out, user.getEmail());
+                }
+                out << ',' << user.getAge() << ',';
+                if (user.getGroup()) writeCsvField(out, user.getGroup()->getId());
+                out << '\n';
+            }
+            return;
+        }
+
+        out << '[';
+        bool first = true;
+        for (const auto& pair : users) {
+            const User& user = *pair.second;
+            out << (first ? "\n  {\"userId\": " : ",\n  {\"userId\": ");
+            first = false;
+            writeJsonString(out, user.getId());
+            out << ", \"username\": ";
+            writeJsonString(out, user.getUsername());
+            out << ", \"email\": ";
+            out << '"';
+            writeJsonEscaped(out, user.getEmailLocal());
+            writeJsonEscaped(out, user.getEmailDomain());
+            out << '"';
+            out << ", \"age\": " << user.getAge() << ", \"groupId\": ";
+            if (user.getGroup()) {
+                writeJsonString(out, user.getGroup()->getId());
+            } else {
+                out << "null";
+            }
+            out << '}';
         }
+        out << "\n]\n";
     }
 
     // Методы для работы с группами
-    bool createGroup(const std::string& groupId) {
+    bool createGroup(std::string_view groupId) {
         if (groups.find(groupId) != groups.end()) return false;
-        groups[groupId] = std::make_unique<Group>(groupId);
+        std::string id(groupId);
+        auto group = std::make_unique<Group>(id);
+        groups.emplace(std::move(id), std::move(group));
         return true;
     }
 
-    bool deleteGroup(const std::string& groupId) {
+    bool deleteGroup(std::string_view groupId) {
         auto it = groups.find(groupId);
         if (it == groups.end()) return false;
 
@@ -157,24 +692,26 @@ public:
         return true;
     }
 
-    void printAllGroups() const {
-        std::cout << "All Groups (" << groups.size() << "):\n";
+    void printAllGroups(std::ostream& stream = std::cout) const {
+        OutputBuffer out(stream);
+        out << "All Groups (" << groups.size() << "):\n";
         for (const auto& pair : groups) {
-            pair.second->printInfo();
+            pair.second->format(out);
         }
     }
 
-    void printGroup(const std::string& groupId) const {
+    void printGroup(std::string_view groupId, std::ostream& stream = std::cout) const {
+        OutputBuffer out(stream);
         auto it = groups.find(groupId);
         if (it != groups.end()) {
-            it->second->printInfo();
+            it->second->format(out);
         } else {
-            std::cout << "Group not found.\n";
+            out << "Group not found.\n";
         }
     }
 
     // Метод для добавления пользователя в группу
-    bool addUserToGroup(const std::string& userId, const std::string& groupId) {
+    bool addUserToGroup(std::string_view userId, std::string_view groupId) {
         auto userIt = users.find(userId);
         auto groupIt = groups.find(groupId);
         
@@ -185,7 +722,7 @@ public:
     }
 
     // Метод для удаления пользователя из группы
-    bool removeUserFromGroup(const std::string& userId, const std::string& groupId) {
+    bool removeUserFromGroup(std::string_view userId, std::string_view groupId) {
         auto userIt = users.find(userId);
         auto groupIt = groups.find(groupId);
         
@@ -194,87 +731,1191 @@ public:
         groupIt->second->removeUser(userIt->second.get());
         return true;
     }
-};
 
-// Функция для обработки команд
-void processCommand(const std::string& command, UserGroupManager& manager) {
-    std::vector<std::string> tokens;
-    size_t start = 0;
-    size_t end = command.find(' ');
-    
-    while (end != std::string::npos) {
-        tokens.push_back(command.substr(start, end - start));
-        start = end + 1;
-        end = command.find(' ', start);
+    // Массовая загрузка пользователей и их групп из пакетов-столбцов:
+    // 1) параллельно по участкам строк: пользователи собираются в локальных
+    //    аренах, считаются хеши id и списки групп участка;
+    // 2) id проверяются на повтор по сегментам хеша (параллельно), индексы
+    //    заранее резервируются под итоговый размер;
+    // 3) списки участников групп строятся параллельной сортировкой подсчётом
+    //    с сохранением порядка строк;
+    // 4) публикация: пользователи, группы и арены переходят в менеджер.
+    // До публикации состояние не меняется: при повторе id (в пакетах или с уже
+    // существующим пользователем) или столбцах разной длины возвращается false.
+    // Отсутствующие группы создаются. Вызывать под той же блокировкой, что и
+    // изменяющие команды. В журнал загрузка не пишется - после неё нужен checkpoint
+    bool bulkLoad(const std::vector<UserColumns>& batches, ThreadPool& pool) {
+        constexpr size_t CHUNK_ROWS = 1 << 16;
+        constexpr size_t SHARDS = 256;
+        constexpr std::uint32_t NO_GROUP = UINT32_MAX;
+
+        size_t total = 0, chunkCount = 0;
+        for (const auto& batch : batches) {
+            if (!batch.consistent()) return false;
+            total += batch.size();
+            chunkCount += (batch.size() + CHUNK_ROWS - 1) / CHUNK_ROWS;
+        }
+        if (total == 0) return true;
+
+        std::vector<BulkChunk> chunks(chunkCount);
+        size_t first = 0, c = 0;
+        for (const auto& batch : batches) {
+            for (size_t begin = 0; begin < batch.size(); begin += CHUNK_ROWS) {
+                chunks[c].batch = &batch;
+                chunks[c].begin = begin;
+                chunks[c].end = std::min(batch.size(), begin + CHUNK_ROWS);
+                chunks[c].first = first;
+                first += chunks[c].end - begin;
+                ++c;
+            }
+        }
+
+        // Фаза 1: разбор и хеширование
+        std::vector<std::unique_ptr<User>> created(total);
+        std::vector<size_t> hashes(total);
+        std::vector<std::uint32_t> rowGroup(total);
+        pool.parallelFor(chunkCount, [&](size_t c) {
+            BulkChunk& chunk = chunks[c];
+            const UserColumns& batch = *chunk.batch;
+            std::unordered_map<std::string_view, std::uint32_t> local;
+            chunk.shardCounts.assign(SHARDS, 0);
+            for (size_t r = chunk.begin, i = chunk.first; r < chunk.end; ++r, ++i) {
+                created[i] = makeUser(chunk.arena, chunk.domains, batch.ids[r], batch.names[r],
+                                      batch.emails[r], batch.ages[r]);
+                hashes[i] = std::hash<std::string_view>{}(created[i]->getId());
+                ++chunk.shardCounts[hashes[i] % SHARDS];
+                std::string_view groupId = batch.groupIds[r];
+                if (groupId.empty()) {
+                    rowGroup[i] = NO_GROUP;
+                    continue;
+                }
+                auto [it, inserted] = local.try_emplace(groupId, static_cast<std::uint32_t>(chunk.groupNames.size()));
+                if (inserted) {
+                    chunk.groupNames.push_back(groupId);
+                    chunk.groupCounts.push_back(0);
+                }
+                ++chunk.groupCounts[it->second];
+                rowGroup[i] = it->second;
+            }
+        });
+
+        // Фаза 2: раскладка строк по сегментам хеша и поиск повторов в сегментах
+        std::vector<size_t> shardStart(SHARDS + 1, 0);
+        for (const auto& chunk : chunks) {
+            for (size_t s = 0; s < SHARDS; ++s) shardStart[s + 1] += chunk.shardCounts[s];
+        }
+        for (size_t s = 0; s < SHARDS; ++s) shardStart[s + 1] += shardStart[s];
+        std::vector<size_t> shardCursor(shardStart.begin(), shardStart.end() - 1);
+        for (auto& chunk : chunks) {
+            for (size_t s = 0; s < SHARDS; ++s) {
+                size_t count = chunk.shardCounts[s];
+                chunk.shardCounts[s] = shardCursor[s];
+                shardCursor[s] += count;
+            }
+        }
+        std::vector<size_t> shardRows(total);
+        pool.parallelFor(chunkCount, [&](size_t c) {
+            BulkChunk& chunk = chunks[c];
+            size_t rows = chunk.end - chunk.begin;
+            for (size_t i = chunk.first; i < chunk.first + rows; ++i) {
+                shardRows[chunk.shardCounts[hashes[i] % SHARDS]++] = i;
+            }
+        });
+
+        std::atomic<bool> duplicate{false};
+        pool.parallelFor(SHARDS, [&](size_t s) {
+            auto begin = shardRows.begin() + shardStart[s];
+            auto end = shardRows.begin() + shardStart[s + 1];
+            std::sort(begin, end, [&](size_t a, size_t b) {
+                if (hashes[a] != hashes[b]) return hashes[a] < hashes[b];
+                return created[a]->getId() < created[b]->getId();
+            });
+            for (auto it = begin; it != end && !duplicate.load(std::memory_order_relaxed); ++it) {
+                std::string_view id = created[*it]->getId();
+                if ((it != begin && hashes[*(it - 1)] == hashes[*it] && created[*(it - 1)]->getId() == id) ||
+                    users.find(id) != users.end()) {
+                    duplicate.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+        if (duplicate) return false;
+
+        // Группы всех участков получают общие номера; новые создаются заранее,
+        // но попадают в индекс только при публикации
+        std::vector<Group*> targets;
+        std::vector<std::unique_ptr<Group>> newGroups;
+        std::unordered_map<std::string_view, std::uint32_t> targetIndex;
+        std::vector<size_t> memberStart(1, 0);
+        for (auto& chunk : chunks) {
+            chunk.groupTargets.resize(chunk.groupNames.size());
+            for (size_t l = 0; l < chunk.groupNames.size(); ++l) {
+                std::string_view name = chunk.groupNames[l];
+                auto [it, inserted] = targetIndex.try_emplace(name, static_cast<std::uint32_t>(targets.size()));
+                if (inserted) {
+                    auto existing = groups.find(name);
+                    if (existing != groups.end()) {
+                        targets.push_back(existing->second.get());
+                    } else {
+                        newGroups.push_back(std::make_unique<Group>(std::string(name)));
+                        targets.push_back(newGroups.back().get());
+                    }
+                    memberStart.push_back(0);
+                }
+                chunk.groupTargets[l] = it->second;
+                memberStart[it->second + 1] += chunk.groupCounts[l];
+            }
+        }
+        users.reserve(users.size() + total);
+        groups.reserve(groups.size() + newGroups.size());
+
+        // Фаза 3: сортировка подсчётом. Участок c пишет участников группы g
+        // сразу после участков с меньшими номерами
+        for (size_t g = 0; g < targets.size(); ++g) memberStart[g + 1] += memberStart[g];
+        std::vector<size_t> memberCursor(memberStart.begin(), memberStart.end() - 1);
+        for (auto& chunk : chunks) {
+            for (size_t l = 0; l < chunk.groupCounts.size(); ++l) {
+                size_t& cursor = memberCursor[chunk.groupTargets[l]];
+                size_t count = chunk.groupCounts[l];
+                chunk.groupCounts[l] = cursor;
+                cursor += count;
+            }
+        }
+        std::vector<User*> members(memberStart.back());
+        pool.parallelFor(chunkCount, [&](size_t c) {
+            BulkChunk& chunk = chunks[c];
+            size_t rows = chunk.end - chunk.begin;
+            for (size_t i = chunk.first; i < chunk.first + rows; ++i) {
+                if (rowGroup[i] != NO_GROUP) members[chunk.groupCounts[rowGroup[i]]++] = created[i].get();
+            }
+        });
+
+        // Фаза 4: публикация. Группы различны и пользователи различны,
+        // поэтому списки участников заполняются параллельно
+        pool.parallelFor(targets.size(), [&](size_t g) {
+            targets[g]->addUsersUnchecked(members.data() + memberStart[g], memberStart[g + 1] - memberStart[g]);
+        });
+        for (auto& group : newGroups) {
+            std::string id = group->getId();
+            groups.emplace(std::move(id), std::move(group));
+        }
+        for (auto& user : created) {
+            std::string_view id = user->getId();
+            users.emplace(id, std::move(user));
+        }
+        for (auto& chunk : chunks) {
+            arena.absorb(chunk.arena);
+            domains.merge(chunk.domains);
+        }
+        return true;
     }
-    tokens.push_back(command.substr(start));
-    
-    if (tokens.empty()) return;
-    
-    if (tokens[0] == "createUser" && tokens.size() >= 4) {
-        int age = tokens.size() > 4 ? std::stoi(tokens[4]) : 0;
-        if (manager.createUser(tokens[1], tokens[2], tokens[3], age)) {
-            std::cout << "User created successfully.\n";
-        } else {
-            std::cout << "Failed to create user (user ID already exists).\n";
+
+    // Подключение хранилища: после этого изменяющие команды пишутся в журнал,
+    // а команда checkpoint сохраняет снимок по указанному пути
+    void attachStorage(std::string path, WriteAheadLog* log) {
+        snapshotPath = std::move(path);
+        wal = log;
+    }
+
+    WriteAheadLog* log() const { return wal; }
+
+    // Сохранение снимка. Файл пишется во временный и затем переименовывается,
+    // чтобы при сбое на диске оставался предыдущий целый снимок
+    bool saveSnapshot(const std::string& path) const {
+        std::string tmpPath = path + ".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+            OutputBuffer out(file);
+
+            out << std::string_view(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+            writePod(out, static_cast<std::uint64_t>(groups.size()));
+            writePod(out, static_cast<std::uint64_t>(users.size()));
+
+            for (const auto& pair : groups) {
+                writeSnapshotString(out, pair.first);
+            }
+
+            std::unordered_map<const User*, std::uint32_t> userIndex;
+            userIndex.reserve(users.size());
+            for (const auto& pair : users) {
+                const User& user = *pair.second;
+                userIndex.emplace(&user, static_cast<std::uint32_t>(userIndex.size()));
+                writeSnapshotString(out, user.getId());
+                writeSnapshotString(out, user.getUsername());
+                writePod(out, static_cast<std::uint32_t>(user.getEmailSize()));
+                out << user.getEmailLocal() << user.getEmailDomain();
+                writePod(out, static_cast<std::int32_t>(user.getAge()));
+            }
+
+            // Участник группы должен быть зарегистрирован и ссылаться на эту же
+            // группу, иначе снимок не восстановит состояние - не сохраняем его
+            for (const auto& pair : groups) {
+                const auto& members = pair.second->getUsers();
+                writePod(out, static_cast<std::uint32_t>(members.size()));
+                for (const User* user : members) {
+                    auto it = userIndex.find(user);
+                    if (it == userIndex.end() || user->getGroup() != pair.second.get()) {
+                        std::cerr << "Snapshot not saved: inconsistent member of group " << pair.first << "\n";
+                        unlink(tmpPath.c_str());
+                        return false;
+                    }
+                    writePod(out, it->second);
+                }
+            }
+            out.flush();
+            if (!file.flush()) {
+                unlink(tmpPath.c_str());
+                return false;
+            }
+        }
+        // Снимок попадает на диск до переименования, а переименование - до
+        // очистки журнала в checkpoint: иначе при отключении питания можно
+        // потерять и снимок, и журнал
+        if (!syncPath(tmpPath) || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+            unlink(tmpPath.c_str());
+            return false;
         }
+        return syncPath(parentDirectory(path));
     }
-    else if (tokens[0] == "deleteUser" && tokens.size() >= 2) {
-        if (manager.deleteUser(tokens[1])) {
-            std::cout << "User deleted successfully.\n";
-        } else {
-            std::cout << "Failed to delete user (user not found).\n";
+
+    // Загрузка снимка через mmap. Текущее состояние заменяется содержимым снимка
+    bool loadSnapshot(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return false;
         }
+        size_t size = static_cast<size_t>(st.st_size);
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) return false;
+        madvise(data, size, MADV_SEQUENTIAL);
+
+        bool loaded = loadSnapshotData(static_cast<const char*>(data), size);
+        munmap(data, size);
+        return loaded;
     }
-    else if (tokens[0] == "allUsers") {
-        manager.printAllUsers();
+
+    // Сохранение снимка и очистка журнала: всё, что было в журнале, уже в снимке.
+    // Заодно сжимается арена строк - checkpoint и так проходит всё состояние
+    bool checkpoint() {
+        if (snapshotPath.empty() || !saveSnapshot(snapshotPath)) return false;
+        compactStrings();
+        return !wal || wal->truncate();
     }
-    else if (tokens[0] == "getUser" && tokens.size() >= 2) {
-        manager.printUser(tokens[1]);
+
+    // Перенос строк живых пользователей в новую арену. Строки удалённых
+    // пользователей остаются в арене, и без сжатия память при создании и
+    // удалении пользователей растёт без предела. Сжатие выполняется, когда
+    // блоки арены больше живых строк более чем вдвое (с запасом в один блок)
+    void compactStrings() {
+        size_t live = 0;
+        for (const auto& pair : users) {
+            const User& user = *pair.second;
+            live += user.getId().size() + user.getUsername().size() + user.getEmailLocal().size();
+        }
+        if (arena.bytesReserved() <= 2 * live + (1 << 20)) return;
+
+        StringArena compacted;
+        StringInterner compactedDomains(compacted);
+        UserIndex rebuilt;
+        rebuilt.reserve(users.size());
+        for (auto& pair : users) {
+            User& user = *pair.second;
+            user.moveStrings(compacted, compactedDomains);
+            rebuilt.emplace(user.getId(), std::move(pair.second));
+        }
+        users = std::move(rebuilt);
+        domains.clear();
+        arena.clear();
+        arena.absorb(compacted);
+        domains.merge(compactedDomains);
     }
-    else if (tokens[0] == "createGroup" && tokens.size() >= 2) {
+
+private:
+    // Участок строк одного пакета для bulkLoad со своей ареной: участки
+    // разбираются параллельно
+    struct BulkChunk {
+        const UserColumns* batch = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+        size_t first = 0;  // номер первой строки участка среди всех пакетов
+        StringArena arena;
+        StringInterner domains{arena};
+        std::vector<size_t> shardCounts;             // строки по сегментам хеша, затем позиции
+        std::vector<std::string_view> groupNames;    // группы участка в порядке появления
+        std::vector<size_t> groupCounts;             // участники по группам, затем позиции
+        std::vector<std::uint32_t> groupTargets;     // общий номер группы
+    };
+
+    std::unique_ptr<User> makeUser(std::string_view id, std::string_view name,
+                                   std::string_view email, int age) {
+        return makeUser(arena, domains, id, name, email, age);
+    }
+
+    static std::unique_ptr<User> makeUser(StringArena& arena, StringInterner& domains,
+                                          std::string_view id, std::string_view name,
+                                          std::string_view email, int age) {
+        size_t at = email.rfind('@');
+        std::string_view local = at == std::string_view::npos ? email : email.substr(0, at + 1);
+        std::string_view domain = at == std::string_view::npos
+            ? std::string_view{} : domains.intern(email.substr(at + 1));
+        return std::make_unique<User>(arena.store(id), arena.store(name), arena.store(local), domain, age);
+    }
+
+    bool loadSnapshotData(const char* data, size_t size) {
+        if (size < sizeof(SNAPSHOT_MAGIC) ||
+            std::memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+            return false;
+        }
+        SnapshotReader in(data + sizeof(SNAPSHOT_MAGIC), size - sizeof(SNAPSHOT_MAGIC));
+        std::uint64_t groupCount = in.pod<std::uint64_t>();
+        std::uint64_t userCount = in.pod<std::uint64_t>();
+        // Каждая запись занимает хотя бы 4 байта - защита от мусорных счётчиков
+        if (!in.good() || groupCount > size / 4 || userCount > size / 4) return false;
+
+        UserIndex loadedUsers;
+        Index<Group> loadedGroups;
+        loadedUsers.reserve(userCount);
+        loadedGroups.reserve(groupCount);
+
+        std::vector<Group*> groupOrder;
+        groupOrder.reserve(groupCount);
+        for (std::uint64_t i = 0; i < groupCount && in.good(); ++i) {
+            std::string id(in.string());
+            auto group = std::make_unique<Group>(id);
+            groupOrder.push_back(group.get());
+            loadedGroups.emplace(std::move(id), std::move(group));
+        }
+
+        std::vector<User*> userOrder;
+        userOrder.reserve(userCount);
+        for (std::uint64_t i = 0; i < userCount && in.good(); ++i) {
+            std::string_view id = in.string();
+            std::string_view name = in.string();
+            std::string_view email = in.string();
+            int age = in.pod<std::int32_t>();
+            if (!in.good()) break;
+            auto user = makeUser(id, name, email, age);
+            userOrder.push_back(user.get());
+            loadedUsers.emplace(user->getId(), std::move(user));
+        }
+
+        for (Group* group : groupOrder) {
+            std::uint32_t memberCount = in.pod<std::uint32_t>();
+            for (std::uint32_t i = 0; i < memberCount && in.good(); ++i) {
+                std::uint32_t index = in.pod<std::uint32_t>();
+                // Пользователь может состоять только в одной группе
+                if (index >= userOrder.size() || userOrder[index]->getGroup()) return false;
+                group->addUserUnchecked(userOrder[index]);
+            }
+            if (!in.good()) return false;
+        }
+        if (!in.good() || groupOrder.size() != groupCount || userOrder.size() != userCount) {
+            return false;
+        }
+
+        users = std::move(loadedUsers);
+        groups = std::move(loadedGroups);
+        return true;
+    }
+};
+
+// Разбиение команды на слова без выделения памяти: токены ссылаются на исходную строку
+struct CommandTokens {
+    static constexpr size_t MAX_TOKENS = 8;
+    std::array<std::string_view, MAX_TOKENS> items;
+    size_t count = 0;
+
+    std::string_view operator[](size_t i) const { return items[i]; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+CommandTokens tokenize(std::string_view command) {
+    CommandTokens tokens;
+    size_t pos = 0;
+    while (pos < command.size() && tokens.count < CommandTokens::MAX_TOKENS) {
+        size_t end = command.find(' ', pos);
+        if (end == std::string_view::npos) end = command.size();
+        std::string_view token = command.substr(pos, end - pos);
+        // Пропускаем пустые токены (повторные пробелы) и '\r' из файлов Windows
+        if (!token.empty() && token.back() == '\r') token.remove_suffix(1);
+        if (!token.empty()) tokens.items[tokens.count++] = token;
+        pos = end + 1;
+    }
+    return tokens;
+}
+
+// Хеш имени команды (FNV-1a). Вычисляется на этапе компиляции для меток switch,
+// поэтому коллизия двух имён команд даст ошибку компиляции (повтор case)
+constexpr std::uint32_t commandHash(std::string_view name) {
+    std::uint32_t h = 2166136261u;
+    for (char c : name) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+enum class CommandId {
+    Unknown,
+    CreateUser, DeleteUser, AllUsers, GetUser,
+    CreateGroup, DeleteGroup, AllGroups, GetGroup,
+    AddUserToGroup, RemoveUserFromGroup, ExportUsers, Checkpoint
+};
+
+CommandId parseCommandId(std::string_view name) {
+    CommandId id = CommandId::Unknown;
+    std::string_view expected;
+    switch (commandHash(name)) {
+        case commandHash("createUser"):          id = CommandId::CreateUser;          expected = "createUser"; break;
+        case commandHash("deleteUser"):          id = CommandId::DeleteUser;          expected = "deleteUser"; break;
+        case commandHash("allUsers"):            id = CommandId::AllUsers;            expected = "allUsers"; break;
+        case commandHash("getUser"):             id = CommandId::GetUser;             expected = "getUser"; break;
+        case commandHash("createGroup"):         id = CommandId::CreateGroup;         expected = "createGroup"; break;
+        case commandHash("deleteGroup"):         id = CommandId::DeleteGroup;         expected = "deleteGroup"; break;
+        case commandHash("allGroups"):           id = CommandId::AllGroups;           expected = "allGroups"; break;
+        case commandHash("getGroup"):            id = CommandId::GetGroup;            expected = "getGroup"; break;
+        case commandHash("addUserToGroup"):      id = CommandId::AddUserToGroup;      expected = "addUserToGroup"; break;
+        case commandHash("removeUserFromGroup"): id = CommandId::RemoveUserFromGroup; expected = "removeUserFromGroup"; break;
+        case commandHash("exportUsers"):         id = CommandId::ExportUsers;         expected = "exportUsers"; break;
+        case commandHash("checkpoint"):          id = CommandId::Checkpoint;          expected = "checkpoint"; break;
+        default: return CommandId::Unknown;
+    }
+    // Хеш совпал - проверяем само имя, чтобы произвольное слово не попало в команду
+    return name == expected ? id : CommandId::Unknown;
+}
+
+// Команды, не изменяющие состояние (их можно выполнять параллельно)
+bool isReadOnlyCommand(CommandId id) {
+    switch (id) {
+        case CommandId::AllUsers:
+        case CommandId::GetUser:
+        case CommandId::AllGroups:
+        case CommandId::GetGroup:
+        case CommandId::ExportUsers:
+        case CommandId::Unknown:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Функция для обработки команд
+void processCommand(std::string_view command, UserGroupManager& manager, std::ostream& out = std::cout) {
+    INSTR_SCOPE("UserGroupManager::processCommand");
+    CommandTokens tokens = tokenize(command);
+    if (tokens.empty()) return;
+
+    // Успешные изменяющие команды дописываются в журнал, если он подключён
+    auto logMutation = [&] {
+        if (WriteAheadLog* wal = manager.log()) wal->append(command);
+    };
+
+    switch (parseCommandId(tokens[0])) {
+    case CommandId::CreateUser:
+        if (tokens.size() < 4) break;
+        {
+            int age = 0;
+            if (tokens.size() > 4) {
+                std::string_view ageStr = tokens[4];
+                std::from_chars(ageStr.data(), ageStr.data() + ageStr.size(), age);
+            }
+            if (manager.createUser(tokens[1], tokens[2], tokens[3], age)) {
+                logMutation();
+                out << "User created successfully.\n";
+            } else {
+                out << "Failed to create user (user ID already exists).\n";
+            }
+        }
+        return;
+    case CommandId::DeleteUser:
+        if (tokens.size() < 2) break;
+        if (manager.deleteUser(tokens[1])) {
+            logMutation();
+            out << "User deleted successfully.\n";
+        } else {
+            out << "Failed to delete user (user not found).\n";
+        }
+        return;
+    case CommandId::AllUsers:
+        manager.printAllUsers(out);
+        return;
+    case CommandId::GetUser:
+        if (tokens.size() < 2) break;
+        manager.printUser(tokens[1], out);
+        return;
+    case CommandId::CreateGroup:
+        if (tokens.size() < 2) break;
         if (manager.createGroup(tokens[1])) {
-            std::cout << "Group created successfully.\n";
+            logMutation();
+            out << "Group created successfully.\n";
         } else {
-            std::cout << "Failed to create group (group ID already exists).\n";
+            out << "Failed to create group (group ID already exists).\n";
         }
-    }
-    else if (tokens[0] == "deleteGroup" && tokens.size() >= 2) {
+        return;
+    case CommandId::DeleteGroup:
+        if (tokens.size() < 2) break;
         if (manager.deleteGroup(tokens[1])) {
-            std::cout << "Group deleted successfully.\n";
+            logMutation();
+            out << "Group deleted successfully.\n";
         } else {
-            std::cout << "Failed to delete group (group not found).\n";
+            out << "Failed to delete group (group not found).\n";
         }
-    }
-    else if (tokens[0] == "allGroups") {
-        manager.printAllGroups();
-    }
-    else if (tokens[0] == "getGroup" && tokens.size() >= 2) {
-        manager.printGroup(tokens[1]);
-    }
-    else if (tokens[0] == "addUserToGroup" && tokens.size() >= 3) {
+        return;
+    case CommandId::AllGroups:
+        manager.printAllGroups(out);
+        return;
+    case CommandId::GetGroup:
+        if (tokens.size() < 2) break;
+        manager.printGroup(tokens[1], out);
+        return;
+    case CommandId::AddUserToGroup:
+        if (tokens.size() < 3) break;
         if (manager.addUserToGroup(tokens[1], tokens[2])) {
-            std::cout << "User added to group successfully.\n";
+            logMutation();
+            out << "User added to group successfully.\n";
         } else {
-            std::cout << "Failed to add user to group (user or group not found).\n";
+            out << "Failed to add user to group (user or group not found).\n";
         }
-    }
-    else if (tokens[0] == "removeUserFromGroup" && tokens.size() >= 3) {
+        return;
+    case CommandId::RemoveUserFromGroup:
+        if (tokens.size() < 3) break;
         if (manager.removeUserFromGroup(tokens[1], tokens[2])) {
-            std::cout << "User removed from group successfully.\n";
+            logMutation();
+            out << "User removed from group successfully.\n";
+        } else {
+            out << "Failed to remove user from group (user or group not found).\n";
+        }
+        return;
+    case CommandId::ExportUsers:
+        if (tokens.size() < 3 || (tokens[1] != "csv" && tokens[1] != "json")) break;
+        {
+            std::ofstream file(std::string(tokens[2]), std::ios::binary);
+            if (!file) {
+                out << "Failed to open export file.\n";
+                return;
+            }
+            manager.exportUsers(file, tokens[1] == "csv" ? ExportFormat::Csv : ExportFormat::Json);
+            out << "Users exported successfully.\n";
+        }
+        return;
+    case CommandId::Checkpoint:
+        if (manager.checkpoint()) {
+            out << "Snapshot saved successfully.\n";
         } else {
-            std::cout << "Failed to remove user from group (user or group not found).\n";
+            out << "Failed to save snapshot (no storage attached or write error).\n";
+        }
+        return;
+    case CommandId::Unknown:
+        break;
+    }
+    out << "Unknown command or invalid arguments.\n";
+}
+
+// Обработка буфера, содержащего команды по одной на строку. Последняя строка
+// может быть без '\n'. Возвращает количество обработанных команд; exited
+// (если задан) сообщает, что обработка остановлена командой exit
+size_t processBuffer(std::string_view buffer, UserGroupManager& manager, std::ostream& out,
+                     bool* exited = nullptr) {
+    size_t processed = 0;
+    if (exited) *exited = false;
+    while (!buffer.empty()) {
+        const void* nl = std::memchr(buffer.data(), '\n', buffer.size());
+        size_t len = nl ? static_cast<const char*>(nl) - buffer.data() : buffer.size();
+        std::string_view line = buffer.substr(0, len);
+        if (line == "exit") {
+            if (exited) *exited = true;
+            break;
+        }
+        processCommand(line, manager, out);
+        ++processed;
+        buffer.remove_prefix(nl ? len + 1 : len);
+    }
+    return processed;
+}
+
+// Пакетный режим: команды читаются из файла (через mmap) или из stdin ("-")
+// большими блоками. Возвращает количество обработанных команд
+size_t runBatch(const char* path, UserGroupManager& manager, std::ostream& out) {
+    if (std::strcmp(path, "-") != 0) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Cannot open " << path << "\n";
+            return 0;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            size_t size = static_cast<size_t>(st.st_size);
+            if (size == 0) {
+                close(fd);
+                return 0;
+            }
+            void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (data == MAP_FAILED) {
+                std::cerr << "Cannot map " << path << "\n";
+                return 0;
+            }
+            madvise(data, size, MADV_SEQUENTIAL);
+            size_t processed = processBuffer({static_cast<const char*>(data), size}, manager, out);
+            munmap(data, size);
+            return processed;
+        }
+        close(fd);
+    }
+
+    // stdin или не обычный файл: читаем блоками, неполную последнюю строку
+    // переносим в начало буфера перед следующим чтением
+    std::FILE* in = std::strcmp(path, "-") == 0 ? stdin : std::fopen(path, "rb");
+    if (!in) return 0;
+    const size_t CHUNK = 1 << 20;
+    std::vector<char> buffer(CHUNK);
+    size_t carry = 0;
+    size_t processed = 0;
+    bool exited = false;
+    while (!exited) {
+        if (carry == buffer.size()) buffer.resize(buffer.size() * 2);
+        size_t got = std::fread(buffer.data() + carry, 1, buffer.size() - carry, in);
+        if (got == 0) break;
+        size_t filled = carry + got;
+        std::string_view view(buffer.data(), filled);
+        size_t lastNl = view.rfind('\n');
+        if (lastNl == std::string_view::npos) {
+            carry = filled;
+            continue;
+        }
+        processed += processBuffer(view.substr(0, lastNl + 1), manager, out, &exited);
+        carry = filled - (lastNl + 1);
+        std::memmove(buffer.data(), buffer.data() + lastNl + 1, carry);
+    }
+    if (carry > 0 && !exited) {
+        processed += processBuffer({buffer.data(), carry}, manager, out);
+    }
+    if (in != stdin) std::fclose(in);
+    return processed;
+}
+
+// Повтор журнала. В отличие от пакетного режима команда выполняется только
+// вместе со своим '\n': строку без него оставила оборванная при сбое запись
+// ("deleteUser u1" от "deleteUser u12"), и она отбрасывается. Файл укорачивается
+// до последней целой записи, чтобы новые команды не склеились с обрывком.
+// replayed - количество выполненных команд
+bool replayLog(const std::string& path, UserGroupManager& manager, size_t& replayed) {
+    replayed = 0;
+    int fd = open(path.c_str(), O_RDWR);
+    if (fd < 0) return errno == ENOENT;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    size_t complete = 0;
+    if (size > 0) {
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return false;
         }
+        madvise(data, size, MADV_SEQUENTIAL);
+        std::string_view log(static_cast<const char*>(data), size);
+        size_t lastNl = log.rfind('\n');
+        complete = lastNl == std::string_view::npos ? 0 : lastNl + 1;
+        std::ostream nullOut(nullptr);
+        replayed = processBuffer(log.substr(0, complete), manager, nullOut);
+        munmap(data, size);
+    }
+    bool ok = complete == size || (ftruncate(fd, static_cast<off_t>(complete)) == 0 && fsync(fd) == 0);
+    close(fd);
+    return ok;
+}
+
+// Открытие хранилища {prefix}.snap + {prefix}.wal: загрузка снимка, повтор
+// хвоста журнала и подключение журнала для новых команд
+bool openStorage(const std::string& prefix, UserGroupManager& manager, WriteAheadLog& wal) {
+    std::string snapshotPath = prefix + ".snap";
+    std::string walPath = prefix + ".wal";
+
+    auto begin = std::chrono::steady_clock::now();
+    bool haveSnapshot = access(snapshotPath.c_str(), F_OK) == 0;
+    if (haveSnapshot && !manager.loadSnapshot(snapshotPath)) {
+        std::cerr << "Snapshot " << snapshotPath << " is corrupted\n";
+        return false;
+    }
+    size_t replayed = 0;
+    if (!replayLog(walPath, manager, replayed)) {
+        std::cerr << "Cannot replay log " << walPath << "\n";
+        return false;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    if (!wal.open(walPath)) {
+        std::cerr << "Cannot open log " << walPath << "\n";
+        return false;
+    }
+    manager.attachStorage(snapshotPath, &wal);
+    std::cerr << "State restored (" << (haveSnapshot ? "snapshot + " : "")
+              << replayed << " logged commands) in "
+              << std::chrono::duration<double>(end - begin).count() << " s\n";
+    return true;
+}
+
+// Генерация потока команд для бенчмарка: группы, пользователи, вступление в группы,
+// удаление части пользователей
+std::string generateCommandStream(size_t userCount, size_t groupCount) {
+    std::string stream;
+    stream.reserve(userCount * 96);
+    for (size_t g = 0; g < groupCount; ++g) {
+        stream += "createGroup g" + std::to_string(g) + "\n";
+    }
+    for (size_t u = 0; u < userCount; ++u) {
+        std::string id = std::to_string(u);
+        stream += "createUser u" + id + " name" + id + " user" + id + "@example.com " + std::to_string(18 + u % 60) + "\n";
+        stream += "addUserToGroup u" + id + " g" + std::to_string(u % groupCount) + "\n";
     }
-    else {
-        std::cout << "Unknown command or invalid arguments.\n";
+    for (size_t u = 0; u < userCount; u += 10) {
+        stream += "deleteUser u" + std::to_string(u) + "\n";
     }
+    return stream;
 }
 
-int main() {
+void runBenchmark(size_t userCount) {
+    std::string stream = generateCommandStream(userCount, 1000);
+    // Поток без буфера: все операции вывода отбрасываются сразу
+    std::ostream nullOut(nullptr);
+
     UserGroupManager manager;
-    std::string command;
-    
+    auto begin = std::chrono::steady_clock::now();
+    size_t processed = processBuffer(stream, manager, nullOut);
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    std::cout << "Commands: " << processed << " (" << stream.size() / (1024 * 1024) << " MiB)\n";
+    std::cout << "Time: " << seconds << " s\n";
+    std::cout << "Throughput: " << static_cast<size_t>(processed / seconds) << " commands/s\n";
+}
+
+// Поток, который только считает записанные байты (для замера скорости вывода)
+class CountingBuf : public std::streambuf {
+public:
+    size_t bytes = 0;
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) ++bytes;
+        return ch;
+    }
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        bytes += static_cast<size_t>(n);
+        return n;
+    }
+};
+
+void runDumpBenchmark(size_t userCount) {
+    UserGroupManager manager;
+    std::ostream nullOut(nullptr);
+    processBuffer(generateCommandStream(userCount, 1000), manager, nullOut);
+
+    auto measure = [](const char* name, auto&& dump) {
+        CountingBuf counter;
+        std::ostream sink(&counter);
+        auto begin = std::chrono::steady_clock::now();
+        dump(sink);
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - begin).count();
+        double mb = counter.bytes / (1024.0 * 1024.0);
+        std::cout << name << ": " << mb << " MiB in " << seconds << " s, "
+                  << mb / seconds << " MiB/s\n";
+    };
+
+    measure("allUsers", [&](std::ostream& sink) { manager.printAllUsers(sink); });
+    measure("allGroups", [&](std::ostream& sink) { manager.printAllGroups(sink); });
+    measure("export csv", [&](std::ostream& sink) { manager.exportUsers(sink, ExportFormat::Csv); });
+    measure("export json", [&](std::ostream& sink) { manager.exportUsers(sink, ExportFormat::Json); });
+}
+
+// Сервер команд на Unix domain socket. Потоки соединений читают и разбирают
+// команды; чтения выполняются сразу под разделяемой блокировкой, изменения
+// собираются в пакеты и применяются по порядку единственным потоком-писателем.
+// Ответ на каждую команду завершается строкой "."
+bool sendAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t sent = send(fd, data.data(), data.size(), 0);
+        if (sent <= 0) return false;
+        data.remove_prefix(static_cast<size_t>(sent));
+    }
+    return true;
+}
+
+class CommandServer {
+public:
+    explicit CommandServer(UserGroupManager& manager) : manager(manager) {}
+
+    bool run(const std::string& socketPath) {
+        int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0) return false;
+
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(addr.sun_path)) {
+            close(listenFd);
+            return false;
+        }
+        std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+        unlink(socketPath.c_str());
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listenFd, 128) != 0) {
+            close(listenFd);
+            return false;
+        }
+
+        std::signal(SIGPIPE, SIG_IGN);
+        std::thread writer(&CommandServer::writerLoop, this);
+        writer.detach();
+        std::cerr << "Listening on " << socketPath << "\n";
+
+        while (true) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) continue;
+            std::thread(&CommandServer::serveConnection, this, fd).detach();
+        }
+    }
+
+private:
+    // Пакет изменяющих команд одного соединения
+    struct MutationBatch {
+        std::vector<std::string_view> commands;
+        std::string output;
+        bool done = false;
+    };
+
+    void writerLoop() {
+        std::ostringstream out;
+        while (true) {
+            std::deque<MutationBatch*> pending;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [this] { return !queue.empty(); });
+                pending.swap(queue);
+            }
+
+            {
+                std::unique_lock<std::shared_mutex> lock(stateMutex);
+                for (MutationBatch* batch : pending) {
+                    out.str({});
+                    for (std::string_view command : batch->commands) {
+                        processCommand(command, manager, out);
+                        out << ".\n";
+                    }
+                    batch->output = out.str();
+                }
+            }
+            if (WriteAheadLog* log = manager.log()) log->flush();
+
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                for (MutationBatch* batch : pending) batch->done = true;
+            }
+            batchDone.notify_all();
+        }
+    }
+
+    void applyMutations(std::vector<std::string_view>& commands, std::string& response) {
+        if (commands.empty()) return;
+        MutationBatch batch;
+        batch.commands.swap(commands);
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queue.push_back(&batch);
+            queueReady.notify_one();
+            batchDone.wait(lock, [&batch] { return batch.done; });
+        }
+        response += batch.output;
+    }
+
+    // Обработка полных строк из буфера. Возвращает false, если клиент прислал exit
+    bool processLines(std::string_view lines, std::string& response, std::ostringstream& readOut) {
+        std::vector<std::string_view> mutations;
+        bool open = true;
+        while (!lines.empty()) {
+            size_t len = lines.find('\n');
+            std::string_view line = lines.substr(0, len);
+            lines.remove_prefix(len == std::string_view::npos ? lines.size() : len + 1);
+
+            CommandTokens tokens = tokenize(line);
+            if (tokens.empty()) continue;
+            if (tokens[0] == "exit") {
+                open = false;
+                break;
+            }
+            if (!isReadOnlyCommand(parseCommandId(tokens[0]))) {
+                mutations.push_back(line);
+                continue;
+            }
+
+            // Чтение должно видеть предыдущие изменения этого же клиента
+            applyMutations(mutations, response);
+            readOut.str({});
+            {
+                std::shared_lock<std::shared_mutex> lock(stateMutex);
+                processCommand(line, manager, readOut);
+            }
+            readOut << ".\n";
+            response += readOut.str();
+        }
+        applyMutations(mutations, response);
+        return open;
+    }
+
+    void serveConnection(int fd) {
+        std::vector<char> buffer(1 << 16);
+        std::string response;
+        std::ostringstream readOut;
+        size_t carry = 0;
+        bool open = true;
+
+        while (open) {
+            if (carry == buffer.size()) buffer.resize(buffer.size() * 2);
+            ssize_t got = recv(fd, buffer.data() + carry, buffer.size() - carry, 0);
+            if (got <= 0) break;
+            size_t filled = carry + static_cast<size_t>(got);
+            std::string_view view(buffer.data(), filled);
+            size_t lastNl = view.rfind('\n');
+            if (lastNl == std::string_view::npos) {
+                carry = filled;
+                continue;
+            }
+
+            response.clear();
+            open = processLines(view.substr(0, lastNl + 1), response, readOut);
+            if (!sendAll(fd, response)) break;
+
+            carry = filled - (lastNl + 1);
+            std::memmove(buffer.data(), buffer.data() + lastNl + 1, carry);
+        }
+        close(fd);
+    }
+
+    UserGroupManager& manager;
+    std::shared_mutex stateMutex;
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::condition_variable batchDone;
+    std::deque<MutationBatch*> queue;
+};
+
+// Генератор нагрузки для сервера: несколько соединений, каждое отправляет
+// команды с заданной глубиной конвейера и замеряет задержку каждого ответа
+void runLoadGenerator(const std::string& socketPath, size_t connections,
+                      size_t commandsPerConnection, size_t depth) {
+    auto connectTo = [&socketPath]() {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+        return fd;
+    };
+
+    const size_t GROUPS = 16;
+    {
+        int fd = connectTo();
+        if (fd < 0) {
+            std::cerr << "Cannot connect to " << socketPath << "\n";
+            return;
+        }
+        std::string setup;
+        for (size_t g = 0; g < GROUPS; ++g) setup += "createGroup load" + std::to_string(g) + "\n";
+        setup += "exit\n";
+        sendAll(fd, setup);
+        char drain[4096];
+        while (recv(fd, drain, sizeof(drain), 0) > 0) {}
+        close(fd);
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::vector<double>> latencies(connections);
+    std::vector<std::thread> threads;
+    std::signal(SIGPIPE, SIG_IGN);
+    auto begin = Clock::now();
+
+    for (size_t c = 0; c < connections; ++c) {
+        threads.emplace_back([&, c] {
+            int fd = connectTo();
+            if (fd < 0) return;
+
+            // Каждая пятая команда изменяющая, остальные - чтение своих пользователей
+            std::string prefix = "c" + std::to_string(c) + "_";
+            std::mt19937 rng(static_cast<unsigned>(c));
+            std::vector<std::string> commands;
+            commands.reserve(commandsPerConnection);
+            size_t created = 0;
+            for (size_t i = 0; i < commandsPerConnection; ++i) {
+                if (i % 10 == 0) {
+                    std::string id = prefix + std::to_string(created++);
+                    commands.push_back("createUser " + id + " name " + id + "@example.com 30\n");
+                } else if (i % 10 == 5) {
+                    commands.push_back("addUserToGroup " + prefix + std::to_string(rng() % created) +
+                                       " load" + std::to_string(rng() % GROUPS) + "\n");
+                } else {
+                    commands.push_back("getUser " + prefix + std::to_string(rng() % created) + "\n");
+                }
+            }
+
+            std::vector<Clock::time_point> sentAt(commandsPerConnection);
+            std::vector<double>& lat = latencies[c];
+            lat.reserve(commandsPerConnection);
+            std::vector<char> buffer(1 << 16);
+            std::string request;
+            size_t carry = 0;
+            size_t sent = 0;
+            size_t done = 0;
+
+            while (done < commandsPerConnection) {
+                request.clear();
+                while (sent < commandsPerConnection && sent - done < depth) {
+                    sentAt[sent] = Clock::now();
+                    request += commands[sent++];
+                }
+                if (!request.empty() && !sendAll(fd, request)) break;
+
+                ssize_t got = recv(fd, buffer.data() + carry, buffer.size() - carry, 0);
+                if (got <= 0) break;
+                size_t filled = carry + static_cast<size_t>(got);
+                auto now = Clock::now();
+                std::string_view view(buffer.data(), filled);
+                size_t consumed = 0;
+                while (true) {
+                    size_t nl = view.find('\n', consumed);
+                    if (nl == std::string_view::npos) break;
+                    if (view.substr(consumed, nl - consumed) == ".") {
+                        lat.push_back(std::chrono::duration<double, std::micro>(now - sentAt[done++]).count());
+                    }
+                    consumed = nl + 1;
+                }
+                carry = filled - consumed;
+                std::memmove(buffer.data(), buffer.data() + consumed, carry);
+                if (carry == buffer.size()) buffer.resize(buffer.size() * 2);
+            }
+            sendAll(fd, "exit\n");
+            close(fd);
+        });
+    }
+    for (auto& t : threads) t.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::vector<double> all;
+    for (auto& lat : latencies) all.insert(all.end(), lat.begin(), lat.end());
+    if (all.empty()) {
+        std::cerr << "No responses received\n";
+        return;
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) {
+        return all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))];
+    };
+    std::cout << "Commands: " << all.size() << " over " << connections
+              << " connections, pipeline depth " << depth << "\n";
+    std::cout << "Throughput: " << static_cast<size_t>(all.size() / seconds) << " commands/s\n";
+    std::cout << "Latency, us: p50 " << percentile(0.5) << ", p99 " << percentile(0.99)
+              << ", p99.9 " << percentile(0.999) << ", max " << all.back() << "\n";
+}
+
+// Текущий объём резидентной памяти процесса (Linux), байт
+size_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Память на пользователя: синтетические пользователи с длинными именами и
+// адресами на 100 общих доменах
+void runMemoryBenchmark(size_t userCount) {
+    UserGroupManager manager;
+    size_t before = residentBytes();
+    char id[32], name[48], email[80];
+    for (size_t u = 0; u < userCount; ++u) {
+        std::snprintf(id, sizeof(id), "user-%010zu", u);
+        std::snprintf(name, sizeof(name), "firstname_lastname_%zu", u);
+        std::snprintf(email, sizeof(email), "firstname.lastname.%zu@company%zu.example.com", u, u % 100);
+        manager.createUser(id, name, email, static_cast<int>(18 + u % 60));
+    }
+    size_t after = residentBytes();
+    std::cout << "Users: " << userCount << "\n";
+    std::cout << "Resident memory: " << (after - before) / (1024 * 1024) << " MiB, "
+              << (after - before) / userCount << " bytes per user\n";
+    std::cout << "String arena: " << manager.stringBytesReserved() / (1024 * 1024) << " MiB, "
+              << manager.distinctEmailDomains() << " distinct email domains\n";
+}
+
+// Массовая загрузка: построчное создание командами против bulkLoad на
+// разном числе потоков (строк в секунду)
+void runBulkBenchmark(size_t rowCount) {
+    constexpr size_t BATCH_ROWS = 100000;
+    constexpr size_t GROUPS = 1000;
+    std::vector<std::string> ids(rowCount), names(rowCount), emails(rowCount), groupNames(GROUPS);
+    char buffer[80];
+    for (size_t u = 0; u < rowCount; ++u) {
+        std::snprintf(buffer, sizeof(buffer), "user-%010zu", u);
+        ids[u] = buffer;
+        std::snprintf(buffer, sizeof(buffer), "firstname_lastname_%zu", u);
+        names[u] = buffer;
+        std::snprintf(buffer, sizeof(buffer), "firstname.lastname.%zu@company%zu.example.com", u, u % 100);
+        emails[u] = buffer;
+    }
+    for (size_t g = 0; g < GROUPS; ++g) groupNames[g] = "g" + std::to_string(g);
+
+    std::vector<UserColumns> batches;
+    for (size_t begin = 0; begin < rowCount; begin += BATCH_ROWS) {
+        UserColumns& batch = batches.emplace_back();
+        for (size_t u = begin; u < std::min(rowCount, begin + BATCH_ROWS); ++u) {
+            batch.ids.push_back(ids[u]);
+            batch.names.push_back(names[u]);
+            batch.emails.push_back(emails[u]);
+            batch.ages.push_back(static_cast<int>(18 + u % 60));
+            batch.groupIds.push_back(groupNames[u % GROUPS]);
+        }
+    }
+
+    auto rowsPerSecond = [rowCount](std::chrono::steady_clock::duration elapsed) {
+        return static_cast<size_t>(rowCount / std::chrono::duration<double>(elapsed).count());
+    };
+
+    double baseline;
+    {
+        UserGroupManager manager;
+        auto begin = std::chrono::steady_clock::now();
+        for (const auto& name : groupNames) manager.createGroup(name);
+        for (size_t u = 0; u < rowCount; ++u) {
+            manager.createUser(ids[u], names[u], emails[u], static_cast<int>(18 + u % 60));
+            manager.addUserToGroup(ids[u], groupNames[u % GROUPS]);
+        }
+        size_t rate = rowsPerSecond(std::chrono::steady_clock::now() - begin);
+        baseline = static_cast<double>(rate);
+        std::cout << "Rows: " << rowCount << ", hardware threads: " << std::thread::hardware_concurrency() << "\n";
+        std::cout << "createUser + addUserToGroup: " << rate << " rows/s\n";
+    }
+    for (size_t threads : {1, 2, 4, 8, 16, 32}) {
+        ThreadPool pool(threads);
+        UserGroupManager manager;
+        auto begin = std::chrono::steady_clock::now();
+        bool loaded = manager.bulkLoad(batches, pool);
+        size_t rate = rowsPerSecond(std::chrono::steady_clock::now() - begin);
+        std::cout << "bulkLoad, " << threads << " threads: " << rate << " rows/s ("
+                  << rate / baseline << "x)" << (loaded ? "" : " FAILED") << "\n";
+    }
+}
+
+void printUsage() {
     std::cout << "User and Group Management System\n";
     std::cout << "Available commands:\n";
     std::cout << "  createUser {userId} {username} {email} [age]\n";
@@ -287,15 +1928,82 @@ int main() {
     std::cout << "  getGroup {groupId}\n";
     std::cout << "  addUserToGroup {userId} {groupId}\n";
     std::cout << "  removeUserFromGroup {userId} {groupId}\n";
+    std::cout << "  exportUsers {csv|json} {file}\n";
+    std::cout << "  checkpoint\n";
     std::cout << "  exit\n\n";
-    
+}
+
+// Запуск:
+//   program [--state {prefix}] ...  - восстановить состояние из {prefix}.snap и
+//                                  {prefix}.wal и журналировать изменения
+//   program                      - интерактивный режим
+//   program --batch {file|-} [-q] - пакетная обработка файла или stdin (-q без вывода)
+//   program --bench [users]      - бенчмарк на сгенерированном потоке команд
+//   program --bench-dump [users] - скорость массового вывода и экспорта (МиБ/с)
+//   program --bench-memory [users] - память на пользователя
+//   program --bench-bulk [rows]  - массовая загрузка bulkLoad на 1..32 потоках
+//   program --serve {socket}     - сервер команд на Unix domain socket
+//   program --load {socket} [connections] [commands] [depth] - генератор нагрузки
+int main(int argc, char* argv[]) {
+    UserGroupManager manager;
+    WriteAheadLog wal;
+
+    if (argc >= 3 && std::strcmp(argv[1], "--state") == 0) {
+        if (!openStorage(argv[2], manager, wal)) return 1;
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (argc >= 3 && std::strcmp(argv[1], "--batch") == 0) {
+        bool quiet = argc >= 4 && std::strcmp(argv[3], "-q") == 0;
+        std::ostream nullOut(nullptr);
+        size_t processed = runBatch(argv[2], manager, quiet ? nullOut : std::cout);
+        std::cerr << "Processed " << processed << " commands\n";
+        return 0;
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--bench") == 0) {
+        runBenchmark(argc >= 3 ? std::stoul(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-dump") == 0) {
+        runDumpBenchmark(argc >= 3 ? std::stoul(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-memory") == 0) {
+        runMemoryBenchmark(argc >= 3 ? std::stoul(argv[2]) : 10000000);
+        return 0;
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-bulk") == 0) {
+        runBulkBenchmark(argc >= 3 ? std::stoul(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc >= 3 && std::strcmp(argv[1], "--serve") == 0) {
+        CommandServer server(manager);
+        if (!server.run(argv[2])) {
+            std::cerr << "Cannot listen on " << argv[2] << "\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 3 && std::strcmp(argv[1], "--load") == 0) {
+        runLoadGenerator(argv[2],
+                         argc >= 4 ? std::stoul(argv[3]) : 8,
+                         argc >= 5 ? std::stoul(argv[4]) : 100000,
+                         argc >= 6 ? std::stoul(argv[5]) : 64);
+        return 0;
+    }
+
+    std::string command;
+    printUsage();
+
     while (true) {
         std::cout << "> ";
-        std::getline(std::cin, command);
+        if (!std::getline(std::cin, command)) break;
         
         if (command == "exit") break;
         
         processCommand(command, manager);
+        if (WriteAheadLog* log = manager.log()) log->flush();
     }
     
     return 0;
@@ -1,5 +1,16 @@
 #include <memory>
 #include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "../hw/Instrumentation.h"
 class OtherClass{};
 OtherClass *ptr_global = new OtherClass;
 
@@ -8,42 +19,274 @@ class MyObject{
 
 };
 
+template <typename T>
+class AtomicMyShared;
+
+// Блок управления: объект и число владеющих им MyShared (и слотов AtomicMyShared)
+template <typename T>
+struct SharedBlock {
+    T* ptr;
+    std::atomic<std::uint64_t> count;
+};
+
 template <typename T>
 class MyShared {
     T* ptr_ = nullptr;
 
-    unsigned int * counter_ = nullptr;
+    SharedBlock<T> * counter_ = nullptr;
+
+    // забрать уже учтённую в counter_ ссылку (для AtomicMyShared)
+    explicit MyShared(SharedBlock<T> * block) : ptr_(block ? block->ptr : nullptr), counter_(block) {}
+
+    friend class AtomicMyShared<T>;
 
     public:
+    // отладочная печать в конструкторах и деструкторе
+    inline static bool trace = true;
+
+    // Указателей на себя нет: перенос объекта можно делать memcpy
+    // (признак для ca::is_trivially_relocatable из sem_4)
+    using trivially_relocatable = std::true_type;
+
+    MyShared() = default;
+
     //конструктор
-    MyShared (T * && ptr):ptr_(ptr), counter_(new unsigned int){
-        (*counter_)++;
-        std::cout << "Ctr " << counter_ << " \n";
+    MyShared (T * && ptr):ptr_(ptr), counter_(new SharedBlock<T>{ptr, 0}){
+        counter_->count++;
+        INSTR_COUNT("MyShared::control_blocks", 1);
+        if (trace) std::cout << "Ctr " << counter_ << " \n";
     }
     //копирующий конструктор
-    MyShared(MyShared <T> &other){
+    MyShared(const MyShared <T> &other){
         counter_ = other.counter_;
-        (*counter_)++;
+        if (counter_) counter_->count.fetch_add(1, std::memory_order_relaxed);
         ptr_ = other.ptr_;
-        std::cout << "Cpy " << counter_ << " \n";
+        if (trace) std::cout << "Cpy " << counter_ << " \n";
+    }
+
+    MyShared(MyShared <T> &&other) noexcept : ptr_(other.ptr_), counter_(other.counter_) {
+        other.ptr_ = nullptr;
+        other.counter_ = nullptr;
+    }
+
+    MyShared& operator=(MyShared <T> other) noexcept {
+        std::swap(ptr_, other.ptr_);
+        std::swap(counter_, other.counter_);
+        return *this;
     }
 
     //деструктор
     ~MyShared(){
-        *counter_ = *counter_ - 1;
-        if ((*counter_) == 0){
-            std::cout << "Dtr " << ptr_ << "\n";
+        if (counter_ == nullptr){
+            return;
+        }
+        if (counter_->count.fetch_sub(1, std::memory_order_acq_rel) == 1){
+            if (trace) std::cout << "Dtr " << ptr_ << "\n";
             delete ptr_;
             delete counter_;
-            std::cout << "Dtr\n";
+            if (trace) std::cout << "Dtr\n";
+        }
+    }
+
+    T* get() const { return ptr_; }
+    T& operator*() const { return *ptr_; }
+    T* operator->() const { return ptr_; }
+    explicit operator bool() const { return ptr_ != nullptr; }
+    std::uint64_t use_count() const { return counter_ ? counter_->count.load(std::memory_order_relaxed) : 0; }
+
+};
+
+// Слот с MyShared, который можно читать и подменять из разных потоков.
+// Разделённый счётчик ссылок: в одном 64-битном слове лежат указатель на
+// блок (младшие 48 бит) и число выданных из слота ссылок (старшие 16 бит).
+// Слот заранее вносит в count блока PREPAID ссылок, и load() обычно берёт
+// одну из них единственным fetch_add на слове, без блокировок и без CAS.
+// Каждые REFILL выданных ссылок читатель докладывает запас в count.
+// Если пополнение задержалось (поток вытеснен) и выдано больше FAST_LIMIT,
+// читатель сам учитывает свою ссылку в count и возвращает её в слово -
+// запас выше FAST_LIMIT резервирует ссылки для таких читателей.
+// При подмене объекта неизрасходованный запас возвращается из count
+template <typename T>
+class AtomicMyShared {
+    static_assert(sizeof(void*) == 8, "pointer and counter are packed into 64 bits");
+
+    static constexpr unsigned COUNT_SHIFT = 48;
+    static constexpr std::uint64_t POINTER_MASK = (std::uint64_t(1) << COUNT_SHIFT) - 1;
+    static constexpr std::uint64_t ONE = std::uint64_t(1) << COUNT_SHIFT;
+    static constexpr std::uint64_t PREPAID = 1 << 15;
+    static constexpr std::uint64_t FAST_LIMIT = PREPAID / 2;
+    static constexpr std::uint64_t REFILL = 1 << 12;
+
+    public:
+    AtomicMyShared() = default;
+    explicit AtomicMyShared(MyShared<T> value) : word_(install(std::move(value))) {}
+
+    AtomicMyShared(const AtomicMyShared&) = delete;
+    AtomicMyShared& operator=(const AtomicMyShared&) = delete;
+
+    ~AtomicMyShared(){
+        release(word_.load(std::memory_order_acquire));
+    }
+
+    MyShared<T> load() const {
+        std::uint64_t word = word_.fetch_add(ONE, std::memory_order_acquire);
+        SharedBlock<T> * block = blockOf(word);
+        if (block == nullptr){
+            return MyShared<T>();
+        }
+        std::uint64_t taken = word >> COUNT_SHIFT;
+        if (taken >= FAST_LIMIT){
+            block->count.fetch_add(1, std::memory_order_relaxed);
+            giveBack(block, 1);
+        } else if (taken + 1 == REFILL){
+            block->count.fetch_add(REFILL, std::memory_order_relaxed);
+            giveBack(block, REFILL);
+        }
+        return MyShared<T>(block);
+    }
+
+    void store(MyShared<T> value) {
+        exchange(std::move(value));
+    }
+
+    MyShared<T> exchange(MyShared<T> value) {
+        std::uint64_t old = word_.exchange(install(std::move(value)), std::memory_order_acq_rel);
+        SharedBlock<T> * block = blockOf(old);
+        if (block == nullptr){
+            return MyShared<T>();
+        }
+        // вернуть неизрасходованный запас, оставив одну ссылку результату
+        block->count.fetch_sub(PREPAID - (old >> COUNT_SHIFT) - 1, std::memory_order_acq_rel);
+        return MyShared<T>(block);
+    }
+
+    private:
+    static SharedBlock<T> * blockOf(std::uint64_t word) {
+        return reinterpret_cast<SharedBlock<T> *>(word & POINTER_MASK);
+    }
+
+    // Слово для слота: ссылка value переходит слоту вместе с запасом
+    static std::uint64_t install(MyShared<T> value) {
+        SharedBlock<T> * block = value.counter_;
+        if (block == nullptr){
+            return 0;
         }
+        std::uint64_t address = reinterpret_cast<std::uint64_t>(block);
+        if ((address & ~POINTER_MASK) != 0){
+            throw std::runtime_error("AtomicMyShared: pointer does not fit into 48 bits");
+        }
+        block->count.fetch_add(PREPAID - 1, std::memory_order_relaxed);
+        value.counter_ = nullptr;
+        value.ptr_ = nullptr;
+        return address;
+    }
+
+    void release(std::uint64_t word) {
+        SharedBlock<T> * block = blockOf(word);
+        if (block != nullptr){
+            block->count.fetch_sub(PREPAID - (word >> COUNT_SHIFT) - 1, std::memory_order_acq_rel);
+            MyShared<T> last(block);
+        }
+    }
+
+    // Уменьшить счётчик выданных ссылок на amount, уже добавленный в count
+    // блока, если в слове всё ещё этот блок. Иначе писатель уже вернул
+    // запас с учётом этих ссылок - добавка в count откатывается. Если блок
+    // успели вернуть в слот, уменьшается счётчик нового слова: для count
+    // блока это равносильно. Читатель держит ссылку, так что блок жив
+    void giveBack(SharedBlock<T> * block, std::uint64_t amount) const {
+        std::uint64_t current = word_.load(std::memory_order_relaxed);
+        while (blockOf(current) == block && (current >> COUNT_SHIFT) >= amount){
+            if (word_.compare_exchange_weak(current, current - amount * ONE, std::memory_order_relaxed)){
+                return;
+            }
+        }
+        block->count.fetch_sub(amount, std::memory_order_relaxed);
+    }
+
+    mutable std::atomic<std::uint64_t> word_{0};
+};
+
+// Для сравнения: тот же слот под мьютексом
+template <typename T>
+class LockedMyShared {
+    public:
+    explicit LockedMyShared(MyShared<T> value) : value_(std::move(value)) {}
+
+    MyShared<T> load() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return value_;
+    }
+
+    void store(MyShared<T> value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::swap(value_, value);
     }
 
+    private:
+    mutable std::mutex mutex_;
+    MyShared<T> value_;
 };
 
-int main(){
+// Бенчмарк: читатели непрерывно берут текущую конфигурацию, писатель
+// подменяет её так часто, как может
+struct Config {
+    std::uint64_t version;
+    std::vector<int> values;
+};
+
+template <typename Slot>
+void runReaders(const char* name, size_t readers, std::chrono::milliseconds duration) {
+    Slot slot(MyShared<Config>(new Config{0, std::vector<int>(64, 1)}));
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> reads{0}, swaps{0}, checksum{0};
+    std::vector<std::thread> threads;
+    for (size_t r = 0; r < readers; ++r){
+        threads.emplace_back([&] {
+            std::uint64_t localReads = 0, localSum = 0;
+            while (!stop.load(std::memory_order_relaxed)){
+                MyShared<Config> config = slot.load();
+                localSum += config->version + config->values[localReads % 64];
+                ++localReads;
+            }
+            reads += localReads;
+            checksum += localSum;
+        });
+    }
+    threads.emplace_back([&] {
+        std::uint64_t version = 0;
+        while (!stop.load(std::memory_order_relaxed)){
+            slot.store(MyShared<Config>(new Config{++version, std::vector<int>(64, 1)}));
+        }
+        swaps += version;
+    });
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(duration).count();
+    std::cout << name << ": " << readers << " readers, " << reads / seconds / 1e6 << " M loads/s, "
+              << swaps / seconds / 1e3 << " K swaps/s (checksum " << checksum << ")\n";
+}
+
+void runBenchmark(size_t readers) {
+    MyShared<Config>::trace = false;
+    runReaders<AtomicMyShared<Config>>("AtomicMyShared", readers, std::chrono::milliseconds(1000));
+    runReaders<LockedMyShared<Config>>("mutex + MyShared", readers, std::chrono::milliseconds(1000));
+}
+
+int main(int argc, char* argv[]){
+    if (argc >= 2 && std::strcmp(argv[1], "--bench") == 0){
+        runBenchmark(argc >= 3 ? std::stoul(argv[2]) : 4);
+        return 0;
+    }
     MyShared<MyObject> ptr = new MyObject;
     auto simple_ptr = new MyObject;
     MyShared<MyObject> ptr2 = ptr;
+
+    AtomicMyShared<MyObject> slot(ptr);
+    MyShared<MyObject> loaded = slot.load();
+    std::cout << "loaded same object " << (loaded.get() == ptr.get()) << "\n";
+    slot.store(MyShared<MyObject>(new MyObject));
+    std::cout << "use_count after store " << ptr.use_count() << "\n";
     return 0;
-}
\ No newline at end of file
+}
@@ -1,4 +1,27 @@
 #include <iostream>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <bit>
+#include <stdexcept>
+#include <limits>
+#include <random>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 
 namespace temp {
@@ -44,45 +67,1045 @@ namespace temp2 {
 
 
 namespace ca {
+    // Число элементов, хранимых внутри объекта: столько, сколько помещается в 64 байта
     template<class T>
+    inline constexpr std::size_t default_inline_capacity = sizeof(T) <= 64 ? 64 / sizeof(T) : 1;
+
+    // Тег конструктора, отображающего файл в память, и его настройки
+    struct map_file_t { explicit map_file_t() = default; };
+    inline constexpr map_file_t map_file{};
+
+    struct map_options {
+        bool populate = false;   // прочитать все страницы сразу (MAP_POPULATE)
+        bool huge_pages = false; // попросить ядро о больших страницах (MADV_HUGEPAGE)
+    };
+
+    // Тривиально переносимый тип: перенос объекта на новое место с
+    // уничтожением старого (relocation) можно делать memcpy. Это тривиально
+    // копируемые типы и типы без указателей на самих себя, объявившие
+    //   using trivially_relocatable = std::true_type;
+    // Шаблон можно и специализировать для чужого типа
+    namespace detail {
+        template<class T>
+        concept declares_trivially_relocatable =
+            requires { typename T::trivially_relocatable; } && bool(T::trivially_relocatable::value);
+    }
+
+    template<class T>
+    struct is_trivially_relocatable
+        : std::bool_constant<std::is_trivially_copyable_v<T> || detail::declares_trivially_relocatable<T>> {};
+
+    template<class T>
+    inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<std::remove_cv_t<T>>::value;
+
+    // Точки настройки ca::swap(a, b) и ca::relocate(from, to) в духе
+    // std::ranges::swap. Тип подключается через ADL - свободной функцией или
+    // friend swap(T&, T&) / relocate(T*, T*). Без неё тривиально переносимые
+    // объекты обмениваются и переносятся memcpy, остальные - перемещением
+    namespace cpo_detail {
+        // Без этих перегрузок обычный поиск внутри точек настройки нашёл бы их самих
+        template<class T> void swap(T &, T &) = delete;
+        template<class T> void relocate(T *, T *) = delete;
+
+        template<class T>
+        concept adl_swappable = (std::is_class_v<T> || std::is_enum_v<T>) &&
+            requires(T &a, T &b) { swap(a, b); };
+
+        template<class T>
+        concept adl_relocatable = std::is_class_v<T> && requires(T *from, T *to) { relocate(from, to); };
+
+        struct swap_fn {
+            template<class T>
+            void operator()(T &a, T &b) const {
+                if constexpr (adl_swappable<T>) {
+                    swap(a, b);
+                } else if constexpr (is_trivially_relocatable_v<T>) {
+                    if (&a == &b) return;
+                    alignas(T) unsigned char tmp[sizeof(T)];
+                    std::memcpy(tmp, &a, sizeof(T));
+                    std::memcpy(static_cast<void *>(&a), &b, sizeof(T));
+                    std::memcpy(static_cast<void *>(&b), tmp, sizeof(T));
+                } else {
+                    T tmp(std::move(a));
+                    a = std::move(b);
+                    b = std::move(tmp);
+                }
+            }
+        };
+
+        // Создать объект в неинициализированной памяти to из *from и уничтожить *from
+        struct relocate_fn {
+            template<class T>
+            void operator()(T *from, T *to) const {
+                if constexpr (adl_relocatable<T>) {
+                    relocate(from, to);
+                } else if constexpr (is_trivially_relocatable_v<T>) {
+                    std::memcpy(static_cast<void *>(to), from, sizeof(T));
+                } else {
+                    std::construct_at(to, std::move(*from));
+                    std::destroy_at(from);
+                }
+            }
+        };
+    }
+
+    // Во вложенном inline-пространстве, чтобы не конфликтовать с friend swap классов ca
+    inline namespace cpo {
+        inline constexpr cpo_detail::swap_fn swap{};
+        inline constexpr cpo_detail::relocate_fn relocate{};
+    }
+
+    template<class T>
+    inline constexpr bool is_nothrow_relocatable_v =
+        is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>;
+
+    // Перенос n объектов в неинициализированную память. При исключении
+    // исходные объекты остаются на месте, в dest ничего не создано
+    template<class T>
+    void uninitialized_relocate_n(T *first, std::size_t n, T *dest) {
+        if constexpr (is_trivially_relocatable_v<T> && !cpo_detail::adl_relocatable<T>) {
+            if (n != 0) std::memcpy(static_cast<void *>(dest), first, n * sizeof(T));
+        } else if constexpr (std::is_nothrow_move_constructible_v<T>) {
+            for (std::size_t i = 0; i < n; ++i) relocate(first + i, dest + i);
+        } else {
+            std::uninitialized_move_n(first, n, dest);
+            std::destroy_n(first, n);
+        }
+    }
+
+    namespace detail {
+        inline constexpr std::ptrdiff_t SORT_INSERTION_THRESHOLD = 16;
+
+        // Вставками: вставляемый элемент переносится во временный буфер, а
+        // сдвиг идёт переносами (memcpy для тривиально переносимых типов).
+        // Если comp бросил исключение, элемент возвращается в "дыру"
+        template<class It, class Compare>
+        void insertion_sort(It first, It last, Compare &comp) {
+            using T = std::iter_value_t<It>;
+            if (first == last) return;
+            for (It i = first + 1; i != last; ++i) {
+                if (!comp(*i, *(i - 1))) continue;
+                if constexpr (is_nothrow_relocatable_v<T>) {
+                    alignas(T) unsigned char buffer[sizeof(T)];
+                    T *tmp = reinterpret_cast<T *>(buffer);
+                    relocate(std::addressof(*i), tmp);
+                    tmp = std::launder(tmp);
+                    It hole = i;
+                    try {
+                        do {
+                            relocate(std::addressof(*(hole - 1)), std::addressof(*hole));
+                            --hole;
+                        } while (hole != first && comp(*tmp, *(hole - 1)));
+                    } catch (...) {
+                        relocate(tmp, std::addressof(*hole));
+                        throw;
+                    }
+                    relocate(tmp, std::addressof(*hole));
+                } else {
+                    for (It j = i; j != first && comp(*j, *(j - 1)); --j) {
+                        ca::swap(*j, *(j - 1));
+                    }
+                }
+            }
+        }
+    }
+
+    // Сортировка, которая переставляет элементы только через ca::swap и
+    // ca::relocate: быстрая сортировка (медиана трёх, разбиение Хоара) и
+    // вставки на коротких участках. При слишком глубокой рекурсии участок
+    // досортировывается std::sort. Не устойчива
+    template<class It, class Compare = std::less<>>
+    void sort(It first, It last, Compare comp = {}) {
+        std::size_t depth = 2 * std::bit_width(static_cast<std::size_t>(last - first));
+        while (last - first > detail::SORT_INSERTION_THRESHOLD) {
+            if (depth-- == 0) {
+                std::sort(first, last, comp);
+                return;
+            }
+            // После медианы трёх *first - опорный, *(last - 1) не меньше его:
+            // оба служат ограничителями внутренних циклов
+            It mid = first + (last - first) / 2;
+            if (comp(*mid, *first)) ca::swap(*mid, *first);
+            if (comp(*(last - 1), *mid)) {
+                ca::swap(*(last - 1), *mid);
+                if (comp(*mid, *first)) ca::swap(*mid, *first);
+            }
+            ca::swap(*first, *mid);
+            It i = first, j = last;
+            while (true) {
+                do ++i; while (comp(*i, *first));
+                do --j; while (comp(*first, *j));
+                if (i >= j) break;
+                ca::swap(*i, *j);
+            }
+            ca::swap(*first, *j);
+            // Рекурсия в меньшую часть, цикл - по большей
+            if (j - first < last - j) {
+                ca::sort(first, j, comp);
+                first = j + 1;
+            } else {
+                ca::sort(j + 1, last, comp);
+                last = j;
+            }
+        }
+        detail::insertion_sort(first, last, comp);
+    }
+
+    // Массив фиксированного размера, неизменяемый после создания.
+    // Элементы создаются копированием value прямо в неинициализированную
+    // память (без конструктора по умолчанию и присваивания). Короткие массивы
+    // (до InlineCapacity элементов) хранятся внутри объекта без выделения
+    // памяти, длинные - в памяти из Allocator
+    template<class T, std::size_t InlineCapacity = default_inline_capacity<T>,
+             class Allocator = std::allocator<T>>
     class ConstArray {
+        using alloc_traits = std::allocator_traits<Allocator>;
+
     public:
-        ConstArray(std::size_t n, const T& value) : m_data(new T[n]), m_size(n) {
-            for (std::size_t i = 0; i < n; i++) {
-                m_data[i] = value;
+        using value_type = T;
+        using allocator_type = Allocator;
+        using const_iterator = const T *;
+
+        ConstArray(std::size_t n, const T& value, const Allocator& alloc = Allocator())
+            : m_alloc(alloc), m_data(allocate(n)), m_size(n) {
+            try {
+                std::uninitialized_fill_n(m_data, n, value);
+            } catch (...) {
+                deallocate();
+                throw;
             }
         }
 
+        // Массив поверх файла из sizeof(T) * n байт: файл отображается только
+        // для чтения (MAP_PRIVATE), элементы не копируются и не создаются.
+        // Страницы общие с page cache, поэтому процессы, открывшие один файл,
+        // делят одну копию данных
+        ConstArray(map_file_t, const std::string& path, map_options options = {},
+                   const Allocator& alloc = Allocator())
+            : m_alloc(alloc) {
+            static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable T can be mapped from a file");
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("Cannot open " + path);
+            }
+            struct stat st{};
+            if (::fstat(fd, &st) != 0 || st.st_size % sizeof(T) != 0) {
+                ::close(fd);
+                throw std::runtime_error("Size of " + path + " is not a multiple of the element size");
+            }
+            std::size_t bytes = static_cast<std::size_t>(st.st_size);
+            if (bytes == 0) {
+                ::close(fd);
+                return;
+            }
+            int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+            if (options.populate) flags |= MAP_POPULATE;
+#endif
+            void *mapped = ::mmap(nullptr, bytes, PROT_READ, flags, fd, 0);
+            ::close(fd);
+            if (mapped == MAP_FAILED) {
+                throw std::runtime_error("Cannot map " + path);
+            }
+#ifdef MADV_HUGEPAGE
+            // Подсказка, а не требование: без поддержки ядра просто игнорируется
+            if (options.huge_pages) ::madvise(mapped, bytes, MADV_HUGEPAGE);
+#endif
+            (void)options;
+            m_data = static_cast<T *>(mapped);
+            m_size = bytes / sizeof(T);
+            m_mapped_bytes = bytes;
+        }
+
+        ConstArray(const ConstArray& other)
+            : m_alloc(alloc_traits::select_on_container_copy_construction(other.m_alloc)),
+              m_data(allocate(other.m_size)), m_size(other.m_size) {
+            try {
+                std::uninitialized_copy_n(other.m_data, other.m_size, m_data);
+            } catch (...) {
+                deallocate();
+                throw;
+            }
+        }
+
+        ConstArray(ConstArray&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+            : m_alloc(std::move(other.m_alloc)) {
+            take(other);
+        }
+
+        ConstArray& operator=(const ConstArray& other) {
+            if (this != &other) {
+                ConstArray copy(other);
+                swap(*this, copy);
+            }
+            return *this;
+        }
+
+        // Как у std::vector: без исключений, только если память other можно
+        // забрать без выделения - аллокатор передаётся или все аллокаторы равны
+        ConstArray& operator=(ConstArray&& other) noexcept(
+            std::is_nothrow_move_constructible_v<T> &&
+            (alloc_traits::propagate_on_container_move_assignment::value ||
+             alloc_traits::is_always_equal::value)) {
+            if (this != &other) {
+                clear();
+                if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+                    m_alloc = std::move(other.m_alloc);
+                }
+                take(other);
+            }
+            return *this;
+        }
+
         ~ConstArray() {
-            delete[] m_data;
+            clear();
         }
 
         std::size_t size() const { return m_size; }
         const T &operator[](std::size_t i) const { return m_data[i]; }
+        const T *data() const { return m_data; }
+        const_iterator begin() const { return m_data; }
+        const_iterator end() const { return m_data + m_size; }
+        bool is_inline() const { return m_data == inline_data(); }
+        bool is_mapped() const { return m_mapped_bytes != 0; }
+        allocator_type get_allocator() const { return m_alloc; }
 
-        friend void swap(ConstArray<T> &a, ConstArray<T> &b) {
-            T *tmp = a.m_data;
-            std::size_t tmp_size = a.m_size;
-            a.m_data = b.m_data;
-            a.m_size = b.m_size;
-            b.m_data = tmp;
-            b.m_size = tmp_size;
+        // O(1) для массивов в куче; если хотя бы один массив хранится внутри
+        // объекта, элементы перемещаются (их не больше InlineCapacity)
+        friend void swap(ConstArray &a, ConstArray &b) noexcept(
+            std::is_nothrow_move_constructible_v<T> &&
+            (alloc_traits::propagate_on_container_swap::value ||
+             alloc_traits::is_always_equal::value)) {
+            if (&a == &b) return;
+            if constexpr (alloc_traits::propagate_on_container_swap::value) {
+                using std::swap;
+                swap(a.m_alloc, b.m_alloc);
+            }
+            if (!a.is_inline() && !b.is_inline()) {
+                std::swap(a.m_data, b.m_data);
+                std::swap(a.m_size, b.m_size);
+                std::swap(a.m_mapped_bytes, b.m_mapped_bytes);
+                return;
+            }
+            ConstArray tmp(std::move(a));
+            a.clear();
+            a.take(b);
+            b.clear();
+            b.take(tmp);
         }
+
     private:
-        T *m_data;
-        std::size_t m_size;
+        T *inline_data() { return std::launder(reinterpret_cast<T *>(m_inline)); }
+        const T *inline_data() const { return std::launder(reinterpret_cast<const T *>(m_inline)); }
+
+        T *allocate(std::size_t n) {
+            return n <= InlineCapacity ? inline_data() : alloc_traits::allocate(m_alloc, n);
+        }
+
+        void deallocate() {
+            if (is_mapped()) {
+                ::munmap(m_data, m_mapped_bytes);
+                m_mapped_bytes = 0;
+            } else if (!is_inline()) {
+                alloc_traits::deallocate(m_alloc, m_data, m_size);
+            }
+            m_data = inline_data();
+            m_size = 0;
+        }
+
+        void clear() {
+            if (!is_mapped()) {
+                std::destroy_n(m_data, m_size);
+            }
+            deallocate();
+        }
+
+        // Забрать содержимое other (this пуст). Отображение файла забирается
+        // всегда, память в куче - если её может освободить наш аллокатор;
+        // иначе элементы перемещаются
+        void take(ConstArray& other) {
+            bool canSteal = other.is_mapped() || (!other.is_inline() &&
+                (alloc_traits::is_always_equal::value || m_alloc == other.m_alloc));
+            if (canSteal) {
+                m_data = other.m_data;
+                m_size = other.m_size;
+                m_mapped_bytes = other.m_mapped_bytes;
+                other.m_mapped_bytes = 0;
+            } else {
+                m_data = allocate(other.m_size);
+                try {
+                    uninitialized_relocate_n(other.m_data, other.m_size, m_data);
+                } catch (...) {
+                    deallocate();
+                    throw;
+                }
+                m_size = other.m_size;
+                if (!other.is_inline()) {
+                    alloc_traits::deallocate(other.m_alloc, other.m_data, other.m_size);
+                }
+            }
+            other.m_data = other.inline_data();
+            other.m_size = 0;
+        }
+
+        [[no_unique_address]] Allocator m_alloc;
+        T *m_data = inline_data();
+        std::size_t m_size = 0;
+        std::size_t m_mapped_bytes = 0; // не 0 - m_data указывает на отображённый файл
+        // Массив нулевой длины недопустим, поэтому при InlineCapacity == 0
+        // место под один элемент всё равно есть (он не используется)
+        alignas(T) unsigned char m_inline[std::max<std::size_t>(InlineCapacity, 1) * sizeof(T)];
     };
 }
 
-// ХИТРЫЙ ТРЮЮЮЮК
+// Векторные операции чтения над ConstArray<int32_t> и ConstArray<double>.
+// Реализация (AVX2, SSE2 или скалярная) выбирается один раз при первом вызове
+// по возможностям процессора. Для остальных типов - обычные циклы
+namespace ca::simd {
+    enum class level { scalar, sse2, avx2 };
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define CA_SIMD_X86 1
+    inline level detect_level() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? level::avx2 : level::sse2;
+    }
+#else
+    inline level detect_level() { return level::scalar; }
+#endif
+
+    inline level &active_level() {
+        static level current = detect_level();
+        return current;
+    }
+
+    // Принудительный выбор реализации (для тестов и замеров); уровень выше
+    // поддерживаемого процессором не включается
+    inline level force_level(level wanted) {
+        level supported = detect_level();
+        active_level() = wanted > supported ? supported : wanted;
+        return active_level();
+    }
+
+    // Скалярные реализации - общие для всех типов и для хвостов векторных циклов
+    template<class T, class Acc>
+    Acc sum_scalar(const T *p, std::size_t n, Acc acc) {
+        for (std::size_t i = 0; i < n; ++i) acc += p[i];
+        return acc;
+    }
+
+    // NaN во входных данных даёт {NaN, NaN} во всех реализациях (векторные
+    // min/max сами по себе возвращают второй операнд и NaN теряли бы)
+    template<class T>
+    std::pair<T, T> minmax_scalar(const T *p, std::size_t n, std::pair<T, T> acc) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if constexpr (std::is_floating_point_v<T>) {
+                if (p[i] != p[i]) return {p[i], p[i]};
+            }
+            if (p[i] < acc.first) acc.first = p[i];
+            if (acc.second < p[i]) acc.second = p[i];
+        }
+        return acc;
+    }
+
+    template<class T>
+    std::size_t find_scalar(const T *p, std::size_t n, const T &value) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (p[i] == value) return i;
+        }
+        return n;
+    }
+
+    template<class T>
+    std::size_t count_scalar(const T *p, std::size_t n, const T &value) {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < n; ++i) count += p[i] == value;
+        return count;
+    }
+
+    template<class T, class Acc>
+    Acc dot_scalar(const T *a, const T *b, std::size_t n, Acc acc) {
+        for (std::size_t i = 0; i < n; ++i) acc += static_cast<Acc>(a[i]) * static_cast<Acc>(b[i]);
+        return acc;
+    }
+
+    template<class T>
+    bool equal_scalar(const T *a, const T *b, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!(a[i] == b[i])) return false;
+        }
+        return true;
+    }
+
+#if defined(CA_SIMD_X86)
+    // ---- SSE2 (есть на любом x86-64) ----
+    inline long long sum_sse2(const std::int32_t *p, std::size_t n) {
+        __m128i acc = _mm_setzero_si128();
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+            __m128i sign = _mm_srai_epi32(v, 31);
+            acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, sign));
+            acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, sign));
+        }
+        alignas(16) long long lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+        return sum_scalar(p + i, n - i, lanes[0] + lanes[1]);
+    }
+
+    inline double sum_sse2(const double *p, std::size_t n) {
+        __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            acc0 = _mm_add_pd(acc0, _mm_loadu_pd(p + i));
+            acc1 = _mm_add_pd(acc1, _mm_loadu_pd(p + i + 2));
+        }
+        alignas(16) double lanes[2];
+        _mm_store_pd(lanes, _mm_add_pd(acc0, acc1));
+        return sum_scalar(p + i, n - i, lanes[0] + lanes[1]);
+    }
+
+    inline std::pair<std::int32_t, std::int32_t> minmax_sse2(const std::int32_t *p, std::size_t n) {
+        __m128i lo = _mm_set1_epi32(p[0]), hi = lo;
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+            // В SSE2 нет min/max для int32 - выбираем через маску сравнения
+            __m128i less = _mm_cmplt_epi32(v, lo);
+            lo = _mm_or_si128(_mm_and_si128(less, v), _mm_andnot_si128(less, lo));
+            __m128i greater = _mm_cmpgt_epi32(v, hi);
+            hi = _mm_or_si128(_mm_and_si128(greater, v), _mm_andnot_si128(greater, hi));
+        }
+        alignas(16) std::int32_t l[4], h[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(l), lo);
+        _mm_store_si128(reinterpret_cast<__m128i *>(h), hi);
+        std::pair<std::int32_t, std::int32_t> acc = minmax_scalar(l, 4, {l[0], h[0]});
+        acc = minmax_scalar(h, 4, acc);
+        return minmax_scalar(p + i, n - i, acc);
+    }
+
+    inline std::pair<double, double> minmax_sse2(const double *p, std::size_t n) {
+        __m128d lo = _mm_set1_pd(p[0]), hi = lo, nan = _mm_setzero_pd();
+        std::size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            __m128d v = _mm_loadu_pd(p + i);
+            lo = _mm_min_pd(lo, v);
+            hi = _mm_max_pd(hi, v);
+            nan = _mm_or_pd(nan, _mm_cmpunord_pd(v, v));
+        }
+        if (_mm_movemask_pd(nan) != 0) return minmax_scalar(p, n, {p[0], p[0]});
+        alignas(16) double l[2], h[2];
+        _mm_store_pd(l, lo);
+        _mm_store_pd(h, hi);
+        return minmax_scalar(p + i, n - i, {std::min(l[0], l[1]), std::max(h[0], h[1])});
+    }
+
+    inline std::size_t find_sse2(const std::int32_t *p, std::size_t n, std::int32_t value) {
+        __m128i needle = _mm_set1_epi32(value);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)), needle);
+            unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(eq)));
+            if (mask) return i + std::countr_zero(mask);
+        }
+        return i + find_scalar(p + i, n - i, value);
+    }
+
+    inline std::size_t find_sse2(const double *p, std::size_t n, double value) {
+        __m128d needle = _mm_set1_pd(value);
+        std::size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            unsigned mask = static_cast<unsigned>(_mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(p + i), needle)));
+            if (mask) return i + std::countr_zero(mask);
+        }
+        return i + find_scalar(p + i, n - i, value);
+    }
+
+    inline std::size_t count_sse2(const std::int32_t *p, std::size_t n, std::int32_t value) {
+        __m128i needle = _mm_set1_epi32(value);
+        std::size_t count = 0;
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)), needle);
+            count += std::popcount(static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(eq))));
+        }
+        return count + count_scalar(p + i, n - i, value);
+    }
+
+    inline std::size_t count_sse2(const double *p, std::size_t n, double value) {
+        __m128d needle = _mm_set1_pd(value);
+        std::size_t count = 0;
+        std::size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            count += std::popcount(static_cast<unsigned>(_mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(p + i), needle))));
+        }
+        return count + count_scalar(p + i, n - i, value);
+    }
+
+    inline double dot_sse2(const double *a, const double *b, std::size_t n) {
+        __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+        }
+        alignas(16) double lanes[2];
+        _mm_store_pd(lanes, _mm_add_pd(acc0, acc1));
+        return dot_scalar(a + i, b + i, n - i, lanes[0] + lanes[1]);
+    }
+
+    inline bool equal_sse2(const std::int32_t *a, const std::int32_t *b, std::size_t n) {
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)),
+                                         _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+            if (_mm_movemask_epi8(eq) != 0xFFFF) return false;
+        }
+        return equal_scalar(a + i, b + i, n - i);
+    }
+
+    inline bool equal_sse2(const double *a, const double *b, std::size_t n) {
+        std::size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            if (_mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i))) != 0x3) return false;
+        }
+        return equal_scalar(a + i, b + i, n - i);
+    }
+
+    // ---- AVX2 (компилируется для этих функций отдельно, вызывается после проверки процессора) ----
+#define CA_AVX2 __attribute__((target("avx2")))
+    CA_AVX2 inline long long sum_avx2(const std::int32_t *p, std::size_t n) {
+        __m256i acc = _mm256_setzero_si256();
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+            acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+            acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+        }
+        alignas(32) long long lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+        return sum_scalar(p + i, n - i, (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]));
+    }
+
+    CA_AVX2 inline double sum_avx2(const double *p, std::size_t n) {
+        __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(p + i));
+            acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(p + i + 4));
+        }
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, _mm256_add_pd(acc0, acc1));
+        return sum_scalar(p + i, n - i, (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]));
+    }
+
+    CA_AVX2 inline std::pair<std::int32_t, std::int32_t> minmax_avx2(const std::int32_t *p, std::size_t n) {
+        __m256i lo = _mm256_set1_epi32(p[0]), hi = lo;
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+            lo = _mm256_min_epi32(lo, v);
+            hi = _mm256_max_epi32(hi, v);
+        }
+        alignas(32) std::int32_t l[8], h[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(l), lo);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(h), hi);
+        std::pair<std::int32_t, std::int32_t> acc = minmax_scalar(l, 8, {l[0], h[0]});
+        acc = minmax_scalar(h, 8, acc);
+        return minmax_scalar(p + i, n - i, acc);
+    }
+
+    CA_AVX2 inline std::pair<double, double> minmax_avx2(const double *p, std::size_t n) {
+        __m256d lo = _mm256_set1_pd(p[0]), hi = lo, nan = _mm256_setzero_pd();
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d v = _mm256_loadu_pd(p + i);
+            lo = _mm256_min_pd(lo, v);
+            hi = _mm256_max_pd(hi, v);
+            nan = _mm256_or_pd(nan, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+        }
+        if (_mm256_movemask_pd(nan) != 0) return minmax_scalar(p, n, {p[0], p[0]});
+        alignas(32) double l[4], h[4];
+        _mm256_store_pd(l, lo);
+        _mm256_store_pd(h, hi);
+        std::pair<double, double> acc = minmax_scalar(l, 4, {l[0], h[0]});
+        acc = minmax_scalar(h, 4, acc);
+        return minmax_scalar(p + i, n - i, acc);
+    }
+
+    CA_AVX2 inline std::size_t find_avx2(const std::int32_t *p, std::size_t n, std::int32_t value) {
+        __m256i needle = _mm256_set1_epi32(value);
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i)), needle);
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+            if (mask) return i + std::countr_zero(mask);
+        }
+        return i + find_scalar(p + i, n - i, value);
+    }
+
+    CA_AVX2 inline std::size_t find_avx2(const double *p, std::size_t n, double value) {
+        __m256d needle = _mm256_set1_pd(value);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d eq = _mm256_cmp_pd(_mm256_loadu_pd(p + i), needle, _CMP_EQ_OQ);
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_pd(eq));
+            if (mask) return i + std::countr_zero(mask);
+        }
+        return i + find_scalar(p + i, n - i, value);
+    }
+
+    CA_AVX2 inline std::size_t count_avx2(const std::int32_t *p, std::size_t n, std::int32_t value) {
+        __m256i needle = _mm256_set1_epi32(value);
+        std::size_t count = 0;
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i)), needle);
+            count += std::popcount(static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(eq))));
+        }
+        return count + count_scalar(p + i, n - i, value);
+    }
+
+    CA_AVX2 inline std::size_t count_avx2(const double *p, std::size_t n, double value) {
+        __m256d needle = _mm256_set1_pd(value);
+        std::size_t count = 0;
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d eq = _mm256_cmp_pd(_mm256_loadu_pd(p + i), needle, _CMP_EQ_OQ);
+            count += std::popcount(static_cast<unsigned>(_mm256_movemask_pd(eq)));
+        }
+        return count + count_scalar(p + i, n - i, value);
+    }
+
+    // Произведения int32 считаются в 64 битах: _mm256_mul_epi32 умножает
+    // чётные элементы, нечётные сдвигаются на их место
+    CA_AVX2 inline long long dot_avx2(const std::int32_t *a, const std::int32_t *b, std::size_t n) {
+        __m256i acc = _mm256_setzero_si256();
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            acc = _mm256_add_epi64(acc, _mm256_mul_epi32(va, vb));
+            acc = _mm256_add_epi64(acc, _mm256_mul_epi32(_mm256_srli_epi64(va, 32), _mm256_srli_epi64(vb, 32)));
+        }
+        alignas(32) long long lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+        return dot_scalar(a + i, b + i, n - i, (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]));
+    }
+
+    CA_AVX2 inline double dot_avx2(const double *a, const double *b, std::size_t n) {
+        __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+            acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+        }
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, _mm256_add_pd(acc0, acc1));
+        return dot_scalar(a + i, b + i, n - i, (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]));
+    }
+
+    CA_AVX2 inline bool equal_avx2(const std::int32_t *a, const std::int32_t *b, std::size_t n) {
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)),
+                                            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+            if (static_cast<unsigned>(_mm256_movemask_epi8(eq)) != 0xFFFFFFFFu) return false;
+        }
+        return equal_scalar(a + i, b + i, n - i);
+    }
+
+    CA_AVX2 inline bool equal_avx2(const double *a, const double *b, std::size_t n) {
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d eq = _mm256_cmp_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), _CMP_EQ_OQ);
+            if (_mm256_movemask_pd(eq) != 0xF) return false;
+        }
+        return equal_scalar(a + i, b + i, n - i);
+    }
+#undef CA_AVX2
+#endif
+
+    template<class T>
+    inline constexpr bool vectorized = std::is_same_v<T, std::int32_t> || std::is_same_v<T, double>;
+
+    // Тип суммы: целые суммируются в long long, остальные - в своём типе
+    template<class T>
+    using sum_type = std::conditional_t<std::is_integral_v<T>, long long, T>;
+
+    // Выбор реализации: macro раскрывается в вызов name_avx2/name_sse2/scalar
+#if defined(CA_SIMD_X86)
+#define CA_DISPATCH(name, scalar_call, ...)                                      \
+    if constexpr (vectorized<T>) {                                               \
+        switch (active_level()) {                                                \
+            case level::avx2: return name##_avx2(__VA_ARGS__);                   \
+            case level::sse2: return name##_sse2(__VA_ARGS__);                   \
+            case level::scalar: break;                                           \
+        }                                                                        \
+    }                                                                            \
+    return scalar_call;
+#else
+#define CA_DISPATCH(name, scalar_call, ...) return scalar_call;
+#endif
+
+    template<class T>
+    sum_type<T> sum(const T *p, std::size_t n) {
+        CA_DISPATCH(sum, sum_scalar(p, n, sum_type<T>{}), p, n)
+    }
+
+    template<class T>
+    std::pair<T, T> minmax(const T *p, std::size_t n) {
+        CA_DISPATCH(minmax, minmax_scalar(p, n, std::pair<T, T>(p[0], p[0])), p, n)
+    }
+
+    template<class T>
+    std::size_t find(const T *p, std::size_t n, const T &value) {
+        CA_DISPATCH(find, find_scalar(p, n, value), p, n, value)
+    }
+
+    template<class T>
+    std::size_t count(const T *p, std::size_t n, const T &value) {
+        CA_DISPATCH(count, count_scalar(p, n, value), p, n, value)
+    }
+
+    template<class T>
+    bool equal(const T *a, const T *b, std::size_t n) {
+        CA_DISPATCH(equal, equal_scalar(a, b, n), a, b, n)
+    }
+
+    // Для int32 в SSE2 нет знакового умножения в 64 бита - этот случай скалярный
+    template<class T>
+    sum_type<T> dot(const T *a, const T *b, std::size_t n) {
+#if defined(CA_SIMD_X86)
+        if constexpr (vectorized<T>) {
+            if (active_level() == level::avx2) return dot_avx2(a, b, n);
+            if constexpr (std::is_same_v<T, double>) {
+                if (active_level() == level::sse2) return dot_sse2(a, b, n);
+            }
+        }
+#endif
+        return dot_scalar(a, b, n, sum_type<T>{});
+    }
+#undef CA_DISPATCH
+}
+
+namespace ca {
+    // Записать элементы массива в файл в формате конструктора с map_file
+    template<class T, std::size_t N, class A>
+    void write_file(const ConstArray<T, N, A> &arr, const std::string &path) {
+        static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable T can be written to a file");
+        std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(std::fopen(path.c_str(), "wb"), &std::fclose);
+        if (!file) {
+            throw std::runtime_error("Cannot create " + path);
+        }
+        if (std::fwrite(arr.data(), sizeof(T), arr.size(), file.get()) != arr.size()) {
+            throw std::runtime_error("Cannot write " + path);
+        }
+    }
+
+    // Пакетные операции над ConstArray (находятся через ADL)
+    template<class T, std::size_t N, class A>
+    simd::sum_type<T> sum(const ConstArray<T, N, A> &arr) {
+        return simd::sum(arr.data(), arr.size());
+    }
+
+    // Если в массиве есть NaN, обе границы - NaN
+    template<class T, std::size_t N, class A>
+    std::pair<T, T> minmax(const ConstArray<T, N, A> &arr) {
+        if (arr.size() == 0) throw std::out_of_range("minmax of empty ConstArray");
+        return simd::minmax(arr.data(), arr.size());
+    }
+
+    template<class T, std::size_t N, class A>
+    T min(const ConstArray<T, N, A> &arr) { return minmax(arr).first; }
+
+    template<class T, std::size_t N, class A>
+    T max(const ConstArray<T, N, A> &arr) { return minmax(arr).second; }
+
+    // Индекс первого элемента, равного value, или size(), если такого нет
+    template<class T, std::size_t N, class A>
+    std::size_t find(const ConstArray<T, N, A> &arr, const T &value) {
+        return simd::find(arr.data(), arr.size(), value);
+    }
+
+    template<class T, std::size_t N, class A>
+    std::size_t count(const ConstArray<T, N, A> &arr, const T &value) {
+        return simd::count(arr.data(), arr.size(), value);
+    }
+
+    template<class T, std::size_t N, class A>
+    simd::sum_type<T> dot(const ConstArray<T, N, A> &a, const ConstArray<T, N, A> &b) {
+        if (a.size() != b.size()) throw std::invalid_argument("dot of ConstArrays of different sizes");
+        return simd::dot(a.data(), b.data(), a.size());
+    }
+
+    template<class T, std::size_t N, class A>
+    bool operator==(const ConstArray<T, N, A> &a, const ConstArray<T, N, A> &b) {
+        return a.size() == b.size() && simd::equal(a.data(), b.data(), a.size());
+    }
+}
+
+// ХИТРЫЙ ТРЮЮЮЮК: вызов без квалификации находит swap по ADL (friend
+// ConstArray), а std::swap остаётся запасным вариантом. Сразу через точку
+// настройки то же самое - ca::swap(a, b)
 template<class T>
 void my_swap(T& a, T& b) {
     using std::swap;
-    std::swap(a, b);
+    swap(a, b);
+}
+
+
+// Бенчмарк: создание и обмен ConstArray против std::vector
+template<class Make>
+double nsPerOp(std::size_t iterations, Make&& make) {
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        make(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+}
+
+void run_benchmark() {
+    const std::size_t iterations = 2000000;
+    volatile int sink = 0;
+    for (std::size_t n : {4, 16, 1000}) {
+        double array_ns = nsPerOp(iterations, [&](std::size_t i) {
+            ca::ConstArray<int> arr(n, static_cast<int>(i));
+            sink = sink + arr[n - 1];
+        });
+        double vector_ns = nsPerOp(iterations, [&](std::size_t i) {
+            std::vector<int> vec(n, static_cast<int>(i));
+            sink = sink + vec[n - 1];
+        });
+        std::cout << "construct n=" << n << ": ConstArray " << array_ns << " ns, std::vector "
+                  << vector_ns << " ns\n";
+    }
+    for (std::size_t n : {2, 1000}) {
+        ca::ConstArray<std::string> a(n, "some long string value"), b(n, "another long string value");
+        std::vector<std::string> va(n, "some long string value"), vb(n, "another long string value");
+        double array_ns = nsPerOp(iterations, [&](std::size_t) { swap(a, b); });
+        double vector_ns = nsPerOp(iterations, [&](std::size_t) { swap(va, vb); });
+        std::cout << "swap<string> n=" << n << ": ConstArray " << array_ns << " ns, std::vector "
+                  << vector_ns << " ns\n";
+    }
+}
+
+// Сортировка вектора ConstArray: std::sort (перемещения) против ca::sort
+// (обмены через friend swap и переносы). Половина массивов хранится внутри
+// объекта, половина - в куче
+void run_sort_benchmark(std::size_t count) {
+    std::mt19937 random(42);
+    std::vector<ca::ConstArray<int>> source;
+    source.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        source.emplace_back(1 + random() % 32, static_cast<int>(random()));
+    }
+    auto less = [](const ca::ConstArray<int> &a, const ca::ConstArray<int> &b) {
+        return a[0] < b[0] || (a[0] == b[0] && a.size() < b.size());
+    };
+    auto ms = [&](auto &&sorter) {
+        std::vector<ca::ConstArray<int>> items(source);
+        auto begin = std::chrono::steady_clock::now();
+        sorter(items.begin(), items.end(), less);
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        if (!std::is_sorted(items.begin(), items.end(), less)) throw std::logic_error("not sorted");
+        return elapsed;
+    };
+    std::cout << "sort " << count << " ConstArray<int>: std::sort "
+              << ms([](auto first, auto last, auto comp) { std::sort(first, last, comp); }) << " ms, ca::sort "
+              << ms([](auto first, auto last, auto comp) { ca::sort(first, last, comp); }) << " ms\n";
+}
+
+// Сравнение реализаций пакетных операций на большом массиве: время и
+// совпадение результатов со скалярной версией
+void run_simd_benchmark() {
+    const std::size_t n = 1 << 24;
+    ca::ConstArray<std::int32_t> ints(n, 7), ints2(n, 3);
+    ca::ConstArray<double> doubles(n, 0.5), doubles2(n, 2.0);
+    const std::pair<ca::simd::level, const char *> levels[] = {
+        {ca::simd::level::scalar, "scalar"}, {ca::simd::level::sse2, "sse2"}, {ca::simd::level::avx2, "avx2"}};
+    for (auto [wanted, name] : levels) {
+        if (ca::simd::force_level(wanted) != wanted) continue;
+        auto ms = [](auto &&op) {
+            auto begin = std::chrono::steady_clock::now();
+            op();
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        };
+        long long isum = 0, idot = 0;
+        double dsum = 0, ddot = 0;
+        std::size_t found = 0, counted = 0;
+        bool equal = false;
+        std::cout << name << ": sum<int> " << ms([&] { isum = sum(ints); })
+                  << " ms, sum<double> " << ms([&] { dsum = sum(doubles); })
+                  << " ms, minmax<int> " << ms([&] { isum += minmax(ints).second; })
+                  << " ms, find<int> " << ms([&] { found = find(ints, 3); })
+                  << " ms, count<double> " << ms([&] { counted = count(doubles, 0.5); })
+                  << " ms, dot<int> " << ms([&] { idot = dot(ints, ints2); })
+                  << " ms, dot<double> " << ms([&] { ddot = dot(doubles, doubles2); })
+                  << " ms, == " << ms([&] { equal = ints == ints; }) << " ms\n";
+        std::cout << "  results: " << isum << " " << dsum << " " << found << " " << counted << " "
+                  << idot << " " << ddot << " " << equal << "\n";
+
+        // NaN в векторной части, в хвосте и в первом элементе
+        for (std::size_t at : {std::size_t(0), std::size_t(5), std::size_t(36)}) {
+            std::vector<double> values(37, 1.0);
+            values[at] = std::numeric_limits<double>::quiet_NaN();
+            auto [lo, hi] = ca::simd::minmax(values.data(), values.size());
+            if (lo == lo || hi == hi) throw std::logic_error(std::string("minmax lost NaN on ") + name);
+        }
+    }
 }
 
+// Загрузка таблицы из файла: чтение в std::vector против отображения в память.
+// Время - до готовности массива и с одним проходом sum по нему
+void run_mmap_benchmark(std::size_t mebibytes) {
+    const std::string path = "/tmp/constarray_bench.bin";
+    const std::size_t n = mebibytes * 1024 * 1024 / sizeof(double);
+    ca::write_file(ca::ConstArray<double>(n, 1.5), path);
+    auto ms = [](auto begin) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<double> copy(n);
+    std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(std::fopen(path.c_str(), "rb"), &std::fclose);
+    if (!file || std::fread(copy.data(), sizeof(double), n, file.get()) != n) {
+        throw std::runtime_error("Cannot read " + path);
+    }
+    double loaded = ms(begin);
+    double total = ca::simd::sum(copy.data(), copy.size());
+    std::cout << "fread into vector: " << loaded << " ms, +sum " << ms(begin) << " ms (" << total << ")\n";
+
+    for (bool populate : {false, true}) {
+        begin = std::chrono::steady_clock::now();
+        ca::ConstArray<double> mapped(ca::map_file, path, {.populate = populate, .huge_pages = true});
+        loaded = ms(begin);
+        total = sum(mapped);
+        std::cout << (populate ? "mmap + MAP_POPULATE: " : "mmap: ") << loaded << " ms, +sum " << ms(begin)
+                  << " ms (" << total << ")\n";
+    }
+    std::remove(path.c_str());
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && std::strcmp(argv[1], "--bench") == 0) {
+        run_benchmark();
+        return 0;
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-mmap") == 0) {
+        run_mmap_benchmark(argc >= 3 ? std::stoul(argv[2]) : 256);
+        return 0;
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-simd") == 0) {
+        run_simd_benchmark();
+        return 0;
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-sort") == 0) {
+        run_sort_benchmark(argc >= 3 ? std::stoul(argv[2]) : 1000000);
+        return 0;
+    }
 
-int main() {
     std::cout << "hi";  // std::operator<<(std::basic_ostream&, const char *)
     // тут короче ADL
     temp::Base b;
@@ -99,5 +1122,11 @@ int main() {
     swap(arr, brr);
     std::cout << arr.size() << " " << arr[0] << std::endl;
     std::cout << brr.size() << " " << brr[0] << std::endl;
+
+    // Копирование и перемещение: короткий массив хранится внутри объекта
+    ca::ConstArray<std::string> words(3, "word"), copy = words;
+    ca::ConstArray<std::string> moved = std::move(words);
+    std::cout << copy.size() << " " << copy[2] << " " << moved.size() << " " << moved[0]
+              << " " << words.size() << std::endl;
     return 0;
 }
@@ -1,29 +1,607 @@
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <vector>
 
-unsigned long long fact(unsigned long n){
-    if (n == 0 || n == 1){
-        return 1;
+namespace detail {
+    // Наибольшее n, для которого n! помещается в T
+    template <class T>
+    consteval std::size_t max_factorial_argument() {
+        T value = 1;
+        std::size_t n = 1;
+        while (value <= std::numeric_limits<T>::max() / (n + 1)) {
+            value *= static_cast<T>(++n);
+        }
+        return n;
+    }
+
+    // Все представимые в T факториалы, вычисленные при компиляции
+    template <class T>
+    consteval auto make_factorial_table() {
+        std::array<T, max_factorial_argument<T>() + 1> table{};
+        table[0] = 1;
+        for (std::size_t n = 1; n < table.size(); ++n) {
+            table[n] = table[n - 1] * static_cast<T>(n);
+        }
+        return table;
     }
-    return n * fact(n - 1);
+}
+
+template <class T = unsigned long long>
+inline constexpr auto factorial_table = detail::make_factorial_table<T>();
+
+// n! из таблицы; для n, при котором n! не помещается в unsigned long long, - исключение
+constexpr unsigned long long fact(unsigned long n){
+    if (n >= factorial_table<>.size()){
+        throw std::overflow_error("factorial does not fit into unsigned long long");
+    }
+    return factorial_table<>[n];
 }
 
 namespace detail {
-    template <unsigned long N>
+    template <unsigned long N, class T>
     struct factorial_impl {
-        static constexpr unsigned long long value = N * factorial_impl<N - 1>::value;
+        static_assert(N < factorial_table<T>.size(), "N! does not fit into the result type");
+        static constexpr T value = factorial_table<T>[N];
     };
+};
 
-    template <>
-    struct factorial_impl<0> {
-        static constexpr unsigned long long value = 1;
-    };
+template <unsigned long N, class T = unsigned long long>
+constexpr T factorial = detail::factorial_impl<N, T>::value;
+
+// Факториалы и обратные факториалы по простому модулю p для n < min(N, p):
+// binom(n, k) = n! / (k! (n - k)!) - три чтения и два умножения. Для n >= p
+// (малый p) binom сводится к таблице теоремой Люка. Таблица может строиться
+// при компиляции (constexpr-объект) или во время работы для больших N
+template <std::size_t N>
+class ModFactorials {
+public:
+    constexpr explicit ModFactorials(std::uint32_t p) : p(p), limit(std::min<std::uint64_t>(N, p)) {
+        if (!isPrime(p)) throw std::invalid_argument("modulus must be prime");
+        fact[0] = 1 % p;
+        for (std::size_t i = 1; i < limit; ++i) {
+            fact[i] = mulMod(fact[i - 1], static_cast<std::uint32_t>(i));
+        }
+        invFact[limit - 1] = powMod(fact[limit - 1], p - 2);
+        for (std::size_t i = limit - 1; i > 0; --i) {
+            invFact[i - 1] = mulMod(invFact[i], static_cast<std::uint32_t>(i));
+        }
+    }
+
+    constexpr std::uint32_t modulus() const { return p; }
+
+    constexpr std::uint32_t factorial(std::uint64_t n) const { return fact[checked(n)]; }
+    constexpr std::uint32_t inverseFactorial(std::uint64_t n) const { return invFact[checked(n)]; }
+
+    constexpr std::uint32_t binom(std::uint64_t n, std::uint64_t k) const {
+        if (k > n) return 0;
+        if (n < limit) {
+            return mulMod(fact[n], mulMod(invFact[k], invFact[n - k]));
+        }
+        if (limit < p) throw std::out_of_range("binom argument exceeds the table");
+        // Люка: C(n, k) = C(n mod p, k mod p) * C(n / p, k / p) (mod p)
+        return mulMod(binom(n % p, k % p), binom(n / p, k / p));
+    }
+
+private:
+    static constexpr bool isPrime(std::uint32_t value) {
+        if (value < 2) return false;
+        for (std::uint32_t d = 2; std::uint64_t(d) * d <= value; ++d) {
+            if (value % d == 0) return false;
+        }
+        return true;
+    }
+
+    constexpr std::uint32_t mulMod(std::uint32_t a, std::uint32_t b) const {
+        return static_cast<std::uint32_t>(std::uint64_t(a) * b % p);
+    }
+
+    constexpr std::uint32_t powMod(std::uint32_t base, std::uint32_t exp) const {
+        std::uint32_t result = 1 % p;
+        for (; exp != 0; exp >>= 1) {
+            if (exp & 1) result = mulMod(result, base);
+            base = mulMod(base, base);
+        }
+        return result;
+    }
+
+    constexpr std::size_t checked(std::uint64_t n) const {
+        if (n >= limit) throw std::out_of_range("factorial argument exceeds the table");
+        return static_cast<std::size_t>(n);
+    }
+
+    std::uint32_t p;
+    std::size_t limit;
+    std::array<std::uint32_t, N> fact{};
+    std::array<std::uint32_t, N> invFact{};
 };
 
-template <unsigned long N>
-constexpr unsigned long long factorial = detail::factorial_impl<N>::value;
+// binom(n, k, p) через таблицу, построенную для модуля p
+template <std::size_t N>
+constexpr std::uint32_t binom(std::uint64_t n, std::uint64_t k, const ModFactorials<N>& table) {
+    return table.binom(n, k);
+}
+
+// Пул потоков: parallelFor раздаёт индексы задач рабочим потокам и
+// вызывающему, пока все не будут выполнены
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+        for (size_t i = 1; i < threads; ++i) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    void parallelFor(size_t count, const std::function<void(size_t)>& task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = &task;
+            taskCount = count;
+            next = 0;
+            active = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+        runTasks(task, count);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return active == 0; });
+        current = nullptr;
+    }
+
+private:
+    void runTasks(const std::function<void(size_t)>& task, size_t count) {
+        for (size_t i = next++; i < count; i = next++) {
+            task(i);
+        }
+    }
+
+    void workerLoop() {
+        size_t seen = 0;
+        while (true) {
+            const std::function<void(size_t)>* task;
+            size_t count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                task = current;
+                count = taskCount;
+            }
+            runTasks(*task, count);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--active == 0) done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* current = nullptr;
+    size_t taskCount = 0;
+    std::atomic<size_t> next{0};
+    size_t active = 0;
+    size_t generation = 0;
+    bool stopping = false;
+};
+
+namespace big {
+    using limb = std::uint32_t;
+
+    namespace detail {
+        // Ниже этого размера (в 32-битных словах) школьное умножение быстрее Карацубы
+        constexpr size_t KARATSUBA_THRESHOLD = 40;
+        // Умножения меньше этого размера не раздаются по потокам
+        constexpr size_t PARALLEL_THRESHOLD = 4096;
+
+        // out[0, na + nb) += a * b
+        inline void mul_school(const limb* a, size_t na, const limb* b, size_t nb, limb* out) {
+            for (size_t i = 0; i < na; ++i) {
+                std::uint64_t carry = 0;
+                std::uint64_t ai = a[i];
+                for (size_t j = 0; j < nb; ++j) {
+                    std::uint64_t t = ai * b[j] + out[i + j] + carry;
+                    out[i + j] = static_cast<limb>(t);
+                    carry = t >> 32;
+                }
+                for (size_t k = i + nb; carry != 0; ++k) {
+                    std::uint64_t t = std::uint64_t(out[k]) + carry;
+                    out[k] = static_cast<limb>(t);
+                    carry = t >> 32;
+                }
+            }
+        }
+
+        // out[0, n) += a[0, na); перенос за пределы n недопустим
+        inline void add_into(limb* out, size_t n, const limb* a, size_t na) {
+            std::uint64_t carry = 0;
+            size_t i = 0;
+            for (; i < na; ++i) {
+                std::uint64_t t = std::uint64_t(out[i]) + a[i] + carry;
+                out[i] = static_cast<limb>(t);
+                carry = t >> 32;
+            }
+            for (; carry != 0 && i < n; ++i) {
+                std::uint64_t t = std::uint64_t(out[i]) + carry;
+                out[i] = static_cast<limb>(t);
+                carry = t >> 32;
+            }
+        }
+
+        // out[0, n) -= a[0, na); результат неотрицателен
+        inline void sub_into(limb* out, size_t n, const limb* a, size_t na) {
+            std::int64_t borrow = 0;
+            size_t i = 0;
+            for (; i < na; ++i) {
+                std::int64_t t = std::int64_t(out[i]) - a[i] - borrow;
+                borrow = t < 0;
+                out[i] = static_cast<limb>(t);
+            }
+            for (; borrow != 0 && i < n; ++i) {
+                std::int64_t t = std::int64_t(out[i]) - borrow;
+                borrow = t < 0;
+                out[i] = static_cast<limb>(t);
+            }
+        }
+
+        inline std::vector<limb> add(const limb* a, size_t na, const limb* b, size_t nb) {
+            if (na < nb) {
+                std::swap(a, b);
+                std::swap(na, nb);
+            }
+            std::vector<limb> sum(a, a + na);
+            sum.push_back(0);
+            add_into(sum.data(), sum.size(), b, nb);
+            return sum;
+        }
+
+        void mul(const limb* a, size_t na, const limb* b, size_t nb, limb* out);
+
+        // Карацуба для na >= nb > na / 2, m = na / 2:
+        // a * b = z2 * B^2m + (z1 - z0 - z2) * B^m + z0, z1 = (a0 + a1)(b0 + b1)
+        // runThree выполняет три умножения (последовательно или параллельно)
+        template<class RunThree>
+        void karatsuba(const limb* a, size_t na, const limb* b, size_t nb, limb* out, RunThree&& runThree) {
+            size_t m = na / 2;
+            std::vector<limb> sa = add(a, m, a + m, na - m);
+            std::vector<limb> sb = add(b, m, b + m, nb - m);
+            std::vector<limb> z1(sa.size() + sb.size(), 0);
+            runThree([&] { mul(a, m, b, m, out); },
+                     [&] { mul(a + m, na - m, b + m, nb - m, out + 2 * m); },
+                     [&] { mul(sa.data(), sa.size(), sb.data(), sb.size(), z1.data()); });
+            sub_into(z1.data(), z1.size(), out, 2 * m);
+            sub_into(z1.data(), z1.size(), out + 2 * m, na + nb - 2 * m);
+            size_t used = z1.size();
+            while (used > 0 && z1[used - 1] == 0) --used;
+            add_into(out + m, na + nb - m, z1.data(), used);
+        }
+
+        // out[0, na + nb) = a * b; out не пересекается с a и b
+        inline void mul(const limb* a, size_t na, const limb* b, size_t nb, limb* out) {
+            std::fill(out, out + na + nb, 0);
+            if (na < nb) {
+                std::swap(a, b);
+                std::swap(na, nb);
+            }
+            if (nb < KARATSUBA_THRESHOLD) {
+                mul_school(a, na, b, nb, out);
+            } else if (na >= 2 * nb) {
+                // Несбалансированные множители: длинный режется на куски по nb слов
+                std::vector<limb> part(2 * nb);
+                for (size_t i = 0; i < na; i += nb) {
+                    size_t len = std::min(nb, na - i);
+                    mul(a + i, len, b, nb, part.data());
+                    add_into(out + i, na + nb - i, part.data(), len + nb);
+                }
+            } else {
+                karatsuba(a, na, b, nb, out, [](auto&& z0, auto&& z2, auto&& z1) {
+                    z0();
+                    z2();
+                    z1();
+                });
+            }
+        }
+    }
+
+    // Неотрицательное целое произвольной длины в словах по 32 бита (младшие первыми)
+    class BigUint {
+    public:
+        BigUint(std::uint64_t value = 0) {
+            while (value != 0) {
+                limbs.push_back(static_cast<limb>(value));
+                value >>= 32;
+            }
+        }
+
+        bool isZero() const { return limbs.empty(); }
+        size_t limbCount() const { return limbs.size(); }
+
+        size_t bitLength() const {
+            return limbs.empty() ? 0 : limbs.size() * 32 - std::countl_zero(limbs.back());
+        }
+
+        BigUint& operator*=(limb factor) {
+            std::uint64_t carry = 0;
+            for (limb& l : limbs) {
+                std::uint64_t t = std::uint64_t(l) * factor + carry;
+                l = static_cast<limb>(t);
+                carry = t >> 32;
+            }
+            if (carry != 0) limbs.push_back(static_cast<limb>(carry));
+            trim();
+            return *this;
+        }
+
+        BigUint& operator<<=(size_t bits) {
+            if (limbs.empty()) return *this;
+            size_t words = bits / 32;
+            unsigned shift = bits % 32;
+            if (shift != 0) {
+                limbs.push_back(0);
+                for (size_t i = limbs.size() - 1; i > 0; --i) {
+                    limbs[i] = (limbs[i] << shift) | (limbs[i - 1] >> (32 - shift));
+                }
+                limbs[0] <<= shift;
+            }
+            limbs.insert(limbs.begin(), words, 0);
+            trim();
+            return *this;
+        }
+
+        friend BigUint operator*(const BigUint& a, const BigUint& b) {
+            BigUint result;
+            if (a.isZero() || b.isZero()) return result;
+            result.limbs.resize(a.limbs.size() + b.limbs.size());
+            detail::mul(a.limbs.data(), a.limbs.size(), b.limbs.data(), b.limbs.size(), result.limbs.data());
+            result.trim();
+            return result;
+        }
+
+        // Умножение больших сбалансированных чисел: три произведения верхнего
+        // уровня Карацубы считаются в пуле параллельно
+        static BigUint multiply(const BigUint& a, const BigUint& b, ThreadPool& pool) {
+            const BigUint& x = a.limbs.size() >= b.limbs.size() ? a : b;
+            const BigUint& y = &x == &a ? b : a;
+            size_t na = x.limbs.size(), nb = y.limbs.size();
+            if (pool.size() == 1 || nb < detail::PARALLEL_THRESHOLD || na >= 2 * nb) {
+                return a * b;
+            }
+            BigUint result;
+            result.limbs.assign(na + nb, 0);
+            detail::karatsuba(x.limbs.data(), na, y.limbs.data(), nb, result.limbs.data(),
+                              [&pool](auto&& z0, auto&& z2, auto&& z1) {
+                                  pool.parallelFor(3, [&](size_t i) {
+                                      if (i == 0) z0();
+                                      else if (i == 1) z2();
+                                      else z1();
+                                  });
+                              });
+            result.trim();
+            return result;
+        }
+
+        friend bool operator==(const BigUint&, const BigUint&) = default;
+
+        // Десятичная запись делением на 10^9; квадратична по длине числа
+        std::string toString() const {
+            if (limbs.empty()) return "0";
+            std::vector<limb> rest = limbs;
+            std::vector<limb> chunks;
+            while (!rest.empty()) {
+                std::uint64_t remainder = 0;
+                for (size_t i = rest.size(); i-- > 0;) {
+                    std::uint64_t cur = (remainder << 32) | rest[i];
+                    rest[i] = static_cast<limb>(cur / 1000000000);
+                    remainder = cur % 1000000000;
+                }
+                chunks.push_back(static_cast<limb>(remainder));
+                while (!rest.empty() && rest.back() == 0) rest.pop_back();
+            }
+            std::string result = std::to_string(chunks.back());
+            for (size_t i = chunks.size() - 1; i-- > 0;) {
+                std::string part = std::to_string(chunks[i]);
+                result.append(9 - part.size(), '0');
+                result += part;
+            }
+            return result;
+        }
+
+    private:
+        void trim() {
+            while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+        }
+
+        std::vector<limb> limbs;
+    };
+
+    namespace detail {
+        // Произведение нечётных чисел lo, lo + 2, ..., hi (lo и hi нечётны)
+        // деревом: множители на каждом уровне примерно одной длины
+        inline BigUint oddProduct(std::uint64_t lo, std::uint64_t hi) {
+            if (lo > hi) return BigUint(1);
+            std::uint64_t count = (hi - lo) / 2 + 1;
+            if (count <= 16) {
+                BigUint result(1);
+                std::uint64_t acc = 1;
+                for (std::uint64_t k = lo; k <= hi; k += 2) {
+                    if (acc > UINT64_MAX / k) {
+                        result = result * BigUint(acc);
+                        acc = 1;
+                    }
+                    acc *= k;
+                }
+                return result * BigUint(acc);
+            }
+            std::uint64_t mid = lo + 2 * (count / 2);
+            return oddProduct(lo, mid - 2) * oddProduct(mid, hi);
+        }
+
+        // Произведение списка чисел попарно, уровнями дерева; на каждом уровне
+        // независимые умножения раздаются пулу
+        inline BigUint productTree(std::vector<BigUint> items, ThreadPool& pool) {
+            if (items.empty()) return BigUint(1);
+            while (items.size() > 1) {
+                std::vector<BigUint> next((items.size() + 1) / 2);
+                if (next.size() == 1) {
+                    return BigUint::multiply(items[0], items[1], pool);
+                }
+                pool.parallelFor(next.size(), [&](size_t i) {
+                    next[i] = 2 * i + 1 < items.size() ? items[2 * i] * items[2 * i + 1] : std::move(items[2 * i]);
+                });
+                items = std::move(next);
+            }
+            return std::move(items[0]);
+        }
+    }
+
+    // n! по схеме "split recursive": n! = 2^(n - popcount(n)) * prod_i O(n >> i),
+    // где O(m) - произведение нечётных чисел до m. O(n >> i) накапливаются:
+    // каждому уровню достаётся лишь новый отрезок нечётных чисел. Все отрезки
+    // режутся на куски, которые перемножаются в пуле деревьями произведений
+    inline BigUint factorial(std::uint64_t n, ThreadPool& pool) {
+        if (n > UINT32_MAX) throw std::out_of_range("factorial argument is too large");
+        if (n < 2) return BigUint(1);
+
+        struct Range { std::uint64_t lo, hi; };
+        std::vector<Range> levels; // нечётные числа (O(n >> (i+1)), O(n >> i)]
+        std::uint64_t high = 1;
+        for (int i = std::bit_width(n) - 1; i >= 0; --i) {
+            std::uint64_t next = ((n >> i) - 1) | 1;
+            levels.push_back({high + 2, next});
+            high = next;
+        }
+
+        std::uint64_t totalOdd = (high - 1) / 2;
+        std::uint64_t chunkOdd = std::max<std::uint64_t>(64, totalOdd / (pool.size() * 8) + 1);
+        struct Chunk { size_t level; std::uint64_t lo, hi; };
+        std::vector<Chunk> chunks;
+        for (size_t l = 0; l < levels.size(); ++l) {
+            for (std::uint64_t lo = levels[l].lo; lo <= levels[l].hi; lo += 2 * chunkOdd) {
+                chunks.push_back({l, lo, std::min(levels[l].hi, lo + 2 * (chunkOdd - 1))});
+            }
+        }
+        std::vector<BigUint> parts(chunks.size());
+        pool.parallelFor(chunks.size(), [&](size_t i) {
+            parts[i] = detail::oddProduct(chunks[i].lo, chunks[i].hi);
+        });
+
+        BigUint odd(1), result(1);
+        size_t c = 0;
+        for (size_t l = 0; l < levels.size(); ++l) {
+            std::vector<BigUint> levelParts;
+            for (; c < chunks.size() && chunks[c].level == l; ++c) {
+                levelParts.push_back(std::move(parts[c]));
+            }
+            if (!levelParts.empty()) {
+                odd = BigUint::multiply(odd, detail::productTree(std::move(levelParts), pool), pool);
+            }
+            result = BigUint::multiply(result, odd, pool);
+        }
+        result <<= n - std::popcount(n);
+        return result;
+    }
+
+    // Наивное n! последовательным умножением на малые числа (для сравнения)
+    inline BigUint factorialNaive(std::uint32_t n) {
+        BigUint result(1);
+        for (std::uint32_t k = 2; k <= n; ++k) result *= k;
+        return result;
+    }
+}
+
+// Бенчмарк: n! деревом произведений (весь пул и один поток) против наивного цикла
+void runBenchmark() {
+    ThreadPool pool;
+    ThreadPool single(1);
+    auto ms = [](auto&& run) {
+        auto begin = std::chrono::steady_clock::now();
+        run();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    };
+    for (std::uint64_t n : {10000ull, 100000ull, 1000000ull}) {
+        big::BigUint parallel, sequential;
+        double parallelMs = ms([&] { parallel = big::factorial(n, pool); });
+        double sequentialMs = ms([&] { sequential = big::factorial(n, single); });
+        std::cout << n << "!: " << parallel.bitLength() << " bits, product tree " << parallelMs << " ms on "
+                  << pool.size() << " threads, " << sequentialMs << " ms on 1 thread";
+        if (n <= 100000) {
+            big::BigUint naive;
+            double naiveMs = ms([&] { naive = big::factorialNaive(static_cast<std::uint32_t>(n)); });
+            std::cout << ", naive loop " << naiveMs << " ms" << (naive == parallel ? "" : " MISMATCH");
+        }
+        std::cout << (parallel == sequential ? "" : " MISMATCH") << std::endl;
+    }
+}
+
+// Бенчмарк: 10^7 запросов binom(n, k) mod p по таблице на 2^20 значений
+void runBinomBenchmark() {
+    constexpr std::uint32_t P = 1000000007;
+    auto table = std::make_unique<ModFactorials<(1 << 20)>>(P);
+    std::uint64_t state = 12345, checksum = 0;
+    const std::size_t queries = 10000000;
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < queries; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        std::uint64_t n = (state >> 33) & ((1 << 20) - 1);
+        std::uint64_t k = (state >> 13) % (n + 1);
+        checksum += binom(n, k, *table);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / queries;
+    std::cout << "binom mod p: " << ns << " ns per query (checksum " << checksum << ")" << std::endl;
+}
 
 int main(int argc, char const *argv[])
 {
+    if (argc >= 2 && std::strcmp(argv[1], "--bench") == 0) {
+        runBenchmark();
+        return 0;
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-binom") == 0) {
+        runBinomBenchmark();
+        return 0;
+    }
     std::cout << fact(17) << std::endl;
     std::cout << factorial<17> << std::endl;
+    std::cout << factorial<20> << " " << factorial<12, std::uint32_t> << std::endl;
+
+    static constexpr ModFactorials<1001> small(1000000007);
+    static_assert(small.binom(10, 3) == 120);
+    std::cout << binom(1000, 500, small) << std::endl;
+    constexpr ModFactorials<7> lucas(7);
+    std::cout << lucas.binom(1000, 500) << std::endl;
+
+    ThreadPool pool;
+    std::cout << big::factorial(25, pool).toString() << std::endl;
+    std::cout << big::factorial(1000, pool).toString().size() << " digits in 1000!" << std::endl;
 }